@@ -0,0 +1,123 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "image_io.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Sampler and decode settings of a texture
+struct TextureParams
+{
+    GLint Wrap;
+    GLint MinFilter; // a mipmap filter makes the loader generate mipmaps
+    GLint MagFilter;
+    int Components; // channels forced at decode, 0 keeps the file's
+
+    bool operator==(const TextureParams &other) const
+    {
+        return Wrap == other.Wrap && MinFilter == other.MinFilter && MagFilter == other.MagFilter &&
+               Components == other.Components;
+    }
+};
+
+// Mipmapped and repeating, for planet surfaces, rings and orbit lines
+const TextureParams SURFACE_TEXTURE = {GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0};
+
+// Clamped without mipmaps, for skybox faces
+const TextureParams SKY_TEXTURE = {GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, 0};
+
+// Bytes uploaded per Update before the rest waits for the next frame
+const size_t ASSET_UPLOAD_BUDGET = 32 * 1024 * 1024;
+
+// Loads textures in the background. Every Load call returns a texture name
+// right away, holding a 1x1 placeholder; the images are decoded on the
+// thread pool and Update uploads them through a pixel buffer object, so the
+// first frames render while the JPEGs are still being decoded.
+// When every image of a texture has a baked .ctex file from tools/bake_assets
+// and the driver supports S3TC, the compressed blocks and their precomputed
+// mip chain are mapped instead and nothing is decoded or generated at runtime.
+// If one of those files is missing, truncated or from an older format the
+// texture falls back to decoding its source images.
+// Files are taken from the mounted asset pack when they are in it.
+// Must be created and updated on the thread that owns the GL context.
+class AssetLoader
+{
+public:
+    explicit AssetLoader(ThreadPool &pool);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    GLuint LoadTexture(const std::string &path, const TextureParams &params = SURFACE_TEXTURE);
+
+    // Same-sized images in the layers of a GL_TEXTURE_2D_ARRAY, decoded as RGB
+    // unless params forces another channel count
+    GLuint LoadTextureArray(const std::vector<std::string> &paths, const TextureParams &params = SURFACE_TEXTURE);
+
+    // Six faces in +X, -X, +Y, -Y, +Z, -Z order
+    GLuint LoadCubemap(const std::vector<std::string> &faces, const TextureParams &params = SKY_TEXTURE);
+
+    // Drop a texture that is about to be deleted, its images are never uploaded
+    void Cancel(GLuint texture);
+
+    // Upload assets whose images are all decoded. At least one asset goes up
+    // per call, then more until budgetBytes have been uploaded.
+    void Update(size_t budgetBytes = ASSET_UPLOAD_BUDGET);
+
+    // Block until every queued asset is decoded and uploaded
+    void Finish();
+
+    // Assets not uploaded yet
+    int Pending() const { return (int)assets.size(); }
+
+    // The texture's images have all been uploaded
+    bool Loaded(GLuint texture) const;
+
+private:
+    struct Image
+    {
+        unsigned char *Pixels = nullptr;
+        BakedImage Baked; // open instead of Pixels for baked textures
+        int Width = 0;
+        int Height = 0;
+        int Channels = 0;
+    };
+
+    struct Asset
+    {
+        GLenum Target;
+        GLuint Texture; // 0 once cancelled
+        TextureParams Params;
+        bool Baked; // every image has a baked file
+        std::vector<std::string> Paths;
+        std::vector<Image> Images;
+        int Remaining; // images still decoding, guarded by mutex
+    };
+
+    GLuint queue(GLenum target, const std::vector<std::string> &paths, const TextureParams &params);
+    void submit(const std::shared_ptr<Asset> &asset, size_t image);
+    bool bakedUsable(const Asset &asset) const;
+    size_t upload(Asset &asset);
+    size_t uploadBaked(Asset &asset);
+
+    ThreadPool &pool;
+    GLuint pixelBuffer;
+    bool compressedTextures; // driver supports S3TC
+    std::vector<std::shared_ptr<Asset>> assets;
+
+    std::mutex mutex;
+    std::condition_variable decoded;
+    int decoding; // decode tasks still running, guarded by mutex
+};
+
+#endif
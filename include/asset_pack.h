@@ -0,0 +1,83 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Archive of resource files written by tools/pack_assets and read through a
+// single memory mapping. Files are stored uncompressed in name order, each
+// starting on a page boundary, so lookups hand out pointers straight into the
+// mapping and related files sit next to each other for the OS readahead.
+//
+// File layout (little endian):
+//   AssetPackHeader
+//   AssetPackEntry[EntryCount], sorted by name
+//   char[NamesSize], entry names without terminators
+//   file contents, each at its Offset from the start of the pack
+
+const char ASSET_PACK_MAGIC[8] = {'S', 'S', 'P', 'A', 'C', 'K', '0', '1'};
+
+// Alignment of every file in the pack
+const uint32_t ASSET_PACK_ALIGNMENT = 4096;
+
+struct AssetPackHeader
+{
+    char Magic[8];
+    uint32_t EntryCount;
+    uint32_t NamesSize;
+};
+
+struct AssetPackEntry
+{
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t NameOffset; // into the name table
+    uint32_t NameLength;
+};
+
+// Contents of a packed file, valid while its pack stays open
+struct AssetView
+{
+    const unsigned char *Data = nullptr;
+    size_t Size = 0;
+
+    bool Valid() const { return Data != nullptr; }
+};
+
+class AssetPack
+{
+public:
+    AssetPack();
+
+    // Returns false and prints a message if the file is missing or malformed
+    bool Open(const std::string &path);
+    bool IsOpen() const { return header != nullptr; }
+
+    int Count() const { return header ? (int)header->EntryCount : 0; }
+    std::string Name(int entry) const;
+
+    // Binary search by name, e.g. "shaders/surface.vs"
+    AssetView Find(const std::string &name) const;
+
+private:
+    MappedFile file;
+    const AssetPackHeader *header;
+    const AssetPackEntry *entries;
+    const char *names;
+};
+
+// Make a pack visible to FindAsset and AssetExists, nullptr to go back to
+// loose files. Mount before any loading starts; the pack must stay open.
+void MountAssetPack(const AssetPack *pack);
+
+// Contents of a resource path from the mounted pack, invalid if no pack is
+// mounted or the file is not in it
+AssetView FindAsset(const std::string &path);
+
+// True if the path is in the mounted pack or exists as a loose file
+bool AssetExists(const std::string &path);
+
+#endif
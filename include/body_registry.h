@@ -0,0 +1,103 @@
+#ifndef BODY_REGISTRY_H
+#define BODY_REGISTRY_H
+
+#include <glm/glm.hpp>
+
+#include "kepler.h"
+
+#include <string>
+#include <vector>
+
+class NBodySystem;
+class Ephemeris;
+
+// Radius of the shared line loop used to draw orbits
+const float ORBIT_MESH_RADIUS = 100.0f;
+
+// Static description of a celestial body, used to populate the registry
+struct BodyDesc
+{
+    const char *Name;
+    float OrbitRadius; // semi-major axis around the parent body
+    float OrbitRate;   // mean motion, multiplied by the global orbit speed
+    float Eccentricity;
+    float Inclination;   // degrees, relative to the XZ plane
+    float AscendingNode; // degrees
+    float Periapsis;     // argument of periapsis, degrees
+    float AxialTilt;   // degrees
+    float SpinRate;    // radians per second around the body's own axis
+    float Mass;        // solar masses, used by the N-body mode
+    float Radius;      // scale applied to the unit sphere mesh
+    const char *Parent; // name of the body this one orbits, nullptr for the origin
+};
+
+// Structure-of-arrays storage for every body in the scene.
+// Bodies are updated in insertion order, so a parent must be added before its satellites.
+class BodyRegistry
+{
+public:
+    // Orbit and spin parameters
+    std::vector<std::string> Name;
+    std::vector<float> OrbitRadius;
+    std::vector<float> OrbitRate;
+    std::vector<float> Eccentricity;
+    std::vector<float> Inclination;
+    std::vector<float> AscendingNode;
+    std::vector<float> Periapsis;
+    std::vector<float> AxialTilt;
+    std::vector<float> SpinRate;
+    std::vector<float> Mass;
+    std::vector<float> Radius;
+    std::vector<int> Parent;
+
+    // Kernel inputs derived from the above
+    std::vector<float> TiltCos;
+    std::vector<float> TiltSin;
+    std::vector<float> Scale;
+
+    // Maps the orbit line loop onto each body's orbit ellipse, relative to its parent
+    std::vector<glm::mat4> Orbit;
+
+    // Layer of the planet texture array, filled in by the renderer; -1 for
+    // bodies drawn from a streamed texture
+    std::vector<float> TextureLayer;
+
+    // Per-frame results
+    std::vector<glm::vec3> Position;
+    std::vector<glm::mat4> Model;
+
+    // Returns the index of the new body, or -1 if its parent is unknown
+    int Add(const BodyDesc &desc);
+    int Find(const std::string &name) const;
+    int Count() const { return (int)Name.size(); }
+
+    // Recompute positions and model matrices of all bodies. Orbits are
+    // evaluated at orbitTime, spins at spinTime.
+    void Update(double orbitTime, double spinTime);
+
+    // Take orbit positions from a precomputed ephemeris while the time is inside
+    // its span, bodies missing from the file keep using the propagator.
+    // The ephemeris must outlive the registry; pass nullptr to detach.
+    void SetEphemeris(const Ephemeris *ephemeris);
+
+    // Append every body to an N-body system at its current position, with the
+    // velocity of its orbit under the system's gravity. Call after Update.
+    void Seed(NBodySystem &system, double orbitTime) const;
+
+    // Take positions from the first Count() bodies of an N-body system,
+    // interpolated between its last two steps
+    void SetPositions(const NBodySystem &system, double alpha);
+
+private:
+    // Bodies on eccentric or inclined orbits are solved with Kepler's equation,
+    // circular ones keep the cheaper closed form from the orbit kernel
+    KeplerOrbits kepler;
+    std::vector<int> keplerBody;
+    std::vector<float> keplerX, keplerY, keplerZ;
+
+    const Ephemeris *ephemeris = nullptr;
+    std::vector<int> ephemerisBody; // index in the ephemeris per body, -1 if absent
+    bool ephemerisCoversKepler = false;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef CUBEMAP_CACHE_H
+#define CUBEMAP_CACHE_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "texture_manager.h"
+
+#include <string>
+#include <vector>
+
+// Seconds an environment stays loaded after it was last drawn
+const double CUBEMAP_UNLOAD_SECONDS = 30.0;
+
+// Skybox environments that load on first use. Add only records the faces;
+// the first Get loads them through the TextureManager, whose loader decodes
+// the six faces on the thread pool in parallel, and the fallback environment
+// is drawn until they have been uploaded. Environments not drawn for
+// unloadSeconds drop their texture and load again when next asked for.
+class CubemapCache
+{
+public:
+    CubemapCache(TextureManager &textures, AssetLoader &loader, double unloadSeconds = CUBEMAP_UNLOAD_SECONDS);
+
+    // Six faces in +X, -X, +Y, -Y, +Z, -Z order, nothing is loaded yet
+    int Add(const std::vector<std::string> &faces);
+
+    // Cubemap to draw this frame for the environment, the fallback's while
+    // it is still loading
+    GLuint Get(int environment, int fallback, double now);
+
+    // Release environments that have been inactive past the timeout
+    void Update(double now);
+
+    bool Loaded(int environment) const;
+
+private:
+    struct Environment
+    {
+        std::vector<std::string> Faces;
+        TextureRef Texture; // null while unloaded
+        double LastUsed = 0.0;
+    };
+
+    TextureManager &textures;
+    AssetLoader &loader;
+    double unloadSeconds;
+    std::vector<Environment> environments;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+
+// Chebyshev ephemeris in the style of the JPL DE files. Time is split into
+// records of equal length; within a record each body has its own number of
+// sub-intervals and its own polynomial order. Positions are relative to the
+// body's parent, in scene units, and time is orbit time as used by BodyRegistry.
+//
+// File layout (little endian):
+//   EphemerisHeader
+//   EphemerisBody[BodyCount]
+//   double[RecordCount][RecordSize], a body's block in a record starts at
+//   its Offset and holds [SubIntervals][3 components][Order] coefficients
+
+const char EPHEMERIS_MAGIC[8] = {'S', 'S', 'E', 'P', 'H', 'E', 'M', '1'};
+
+struct EphemerisHeader
+{
+    char Magic[8];
+    uint32_t BodyCount;
+    uint32_t RecordCount;
+    uint32_t RecordSize; // doubles per record
+    uint32_t Reserved;
+    double StartTime;
+    double RecordLength;
+};
+
+struct EphemerisBody
+{
+    char Name[24];
+    uint32_t Order;        // coefficients per component
+    uint32_t SubIntervals; // per record
+    uint32_t Offset;       // first coefficient within a record
+    uint32_t Reserved;
+};
+
+// Chebyshev series sum(c[k] * T_k(x)) for x in [-1, 1] by Clenshaw's recurrence
+inline double Clenshaw(const double *c, int n, double x)
+{
+    double b1 = 0.0, b2 = 0.0;
+    for (int k = n - 1; k >= 1; k--)
+    {
+        double b0 = 2.0 * x * b1 - b2 + c[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return c[0] + x * b1 - b2;
+}
+
+// Position in [-1, 1] of the j-th of n Chebyshev nodes
+double ChebyshevNode(int j, int n);
+
+// Coefficients of the degree n-1 interpolant through samples taken at the n Chebyshev nodes
+void FitChebyshev(const double *samples, int n, double *coefficients);
+
+// Read-only view of a memory-mapped ephemeris file
+class Ephemeris
+{
+public:
+    Ephemeris();
+
+    // Returns false and prints a message if the file is missing or malformed
+    bool Load(const std::string &path);
+    bool IsLoaded() const { return header != nullptr; }
+
+    int Count() const { return header ? (int)header->BodyCount : 0; }
+    std::string Name(int body) const;
+    int Find(const std::string &name) const;
+
+    double StartTime() const { return header->StartTime; }
+    double EndTime() const { return header->StartTime + header->RecordLength * header->RecordCount; }
+    bool Covers(double time) const { return header && time >= StartTime() && time <= EndTime(); }
+
+    // Position of a body at a time inside the covered span
+    void Evaluate(int body, double time, double &x, double &y, double &z) const;
+
+private:
+    MappedFile file;
+    const EphemerisHeader *header;
+    const EphemerisBody *bodies;
+    const double *coefficients;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <../external/glad/include/glad/glad.h>
+#include <glm/glm.hpp>
+
+// Uniform block binding point shared by every program that declares FrameConstants
+const GLuint FRAME_CONSTANTS_BINDING = 0;
+
+// Frames the CPU may run ahead of the GPU before it has to wait
+const int FRAME_RING_SIZE = 3;
+
+// Mirrors the std140 block every shader includes from shaders/frame_constants.glsl:
+//
+// layout (std140) uniform FrameConstants
+// {
+//     mat4 view;             // camera view, scene rotation included
+//     mat4 projection;
+//     mat4 skyView;          // camera rotation only
+//     mat4 screenProjection; // orthographic, in pixels
+//     vec4 viewport;         // width, height, 1 / width, 1 / height
+// };
+struct FrameConstants
+{
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::mat4 SkyView;
+    glm::mat4 ScreenProjection;
+    glm::vec4 Viewport;
+};
+
+// Uniform buffer holding FRAME_RING_SIZE copies of FrameConstants. Each frame
+// writes the next slice with an unsynchronized map, so it never waits on a
+// draw that still reads an older slice; a fence per slice guards against
+// the CPU lapping the GPU.
+class FrameUniformBuffer
+{
+public:
+    FrameUniformBuffer();
+    ~FrameUniformBuffer();
+
+    // Upload the constants for this frame and bind them at FRAME_CONSTANTS_BINDING
+    void Update(const FrameConstants &constants);
+
+    // Call once all draws that read the constants have been issued
+    void EndFrame();
+
+private:
+    GLuint buffer;
+    GLsizeiptr stride; // slice size rounded up to the offset alignment
+    int slice;
+    GLsync fences[FRAME_RING_SIZE];
+};
+
+#endif
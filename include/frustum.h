@@ -0,0 +1,51 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include "simd_math.h"
+
+#include <vector>
+
+// View frustum as six inward-facing planes (xyz normal, w distance), in
+// whatever space the matrix it was extracted from maps to clip space
+struct Frustum
+{
+    glm::vec4 Planes[6]; // left, right, bottom, top, near, far
+
+    // Planes of projection * view (* model), normalised so that plane
+    // distances are in world units (Gribb and Hartmann)
+    void Extract(const glm::mat4 &viewProjection);
+
+    // False only if the sphere lies entirely outside one of the planes
+    bool SphereVisible(const glm::vec3 &center, float radius) const;
+};
+
+// Bounding spheres in structure-of-arrays form, so CullSpheres tests
+// several against each plane at once
+struct BoundingSpheres
+{
+    std::vector<float> X, Y, Z, Radius;
+
+    int Count() const { return (int)X.size(); }
+    void Clear();
+    // Returns the index of the sphere
+    int Add(const glm::vec3 &center, float radius);
+};
+
+// Sets visible[i] to 1 for every sphere that may be in view and to 0 for
+// those entirely outside one of the planes
+void CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, unsigned char *visible);
+
+// Same, forcing a specific instruction set; it is clamped to what the CPU supports
+void CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, unsigned char *visible, SimdLevel level);
+
+// Instruction set picked at startup for CullSpheres
+SimdLevel FrustumCullLevel();
+
+// Radius in pixels of a sphere's projection, approximated at its center
+// distance; viewportHeight is in pixels
+float ScreenRadius(const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight,
+                   const glm::vec3 &center, float radius);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "mapped_file.h"
+#include "texture_file.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// From EXT_texture_compression_s3tc, which glad was generated without
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+
+// Texel size assumed for texture memory budgets, drivers pad RGB8 to four bytes
+const size_t BYTES_PER_TEXEL = 4;
+
+// Image decoding and upload staging shared by the texture loaders. Images
+// come from the mounted asset pack when it has them, else from loose files.
+
+// Reads only the image header
+bool ReadImageSize(const std::string &path, int &width, int &height);
+
+// Decodes with stb_image, forcing components channels unless it is 0.
+// Returns null on failure, free the pixels with stbi_image_free.
+unsigned char *DecodeImage(const std::string &path, int &width, int &height, int &channels, int components);
+
+// Decodes as tightly packed RGB, printing a message on failure
+bool DecodeImageRGB(const std::string &path, std::vector<unsigned char> &pixels, int &width, int &height);
+
+// The driver can sample S3TC textures, checked once on the GL thread
+bool CompressedTexturesSupported();
+
+// A baked .ctex file from tools/bake_assets, taken from the asset pack or
+// mapped from disk. Only the header is read when it opens, the blocks are
+// paged in as they are copied.
+class BakedImage
+{
+public:
+    BakedImage() : data(nullptr) {}
+
+    // Opens the file baked from source. Returns false if it can't be read or
+    // fails ValidateTextureFile, which prints why.
+    bool Open(const std::string &source);
+    void Close();
+
+    // Null unless open
+    const unsigned char *Data() const { return data; }
+    const TextureFileHeader *Header() const { return (const TextureFileHeader *)data; }
+    const TextureFileLevel &Level(int level) const
+    {
+        return ((const TextureFileLevel *)(data + sizeof(TextureFileHeader)))[level];
+    }
+
+private:
+    const unsigned char *data;
+    std::unique_ptr<MappedFile> file; // holds data unless it came from the asset pack
+};
+
+// Binds buffer to GL_PIXEL_UNPACK_BUFFER with room for size bytes and maps it
+// for writing. The previous contents are orphaned, so this never waits on an
+// earlier transfer. Returns null if mapping fails, the buffer stays bound.
+unsigned char *MapPixelBuffer(GLuint buffer, size_t size);
+
+// Copies size bytes into the mapped buffer and unmaps it, leaving it bound so
+// the texture calls that follow read from it. Returns false on failure.
+bool StagePixels(GLuint buffer, const void *data, size_t size);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include "simd_math.h"
+
+#include <vector>
+
+// Fixed number of Halley iterations after the M + e*sin(M) starter.
+// Enough for single precision up to e = 0.95, and keeps every lane in step.
+const int KEPLER_ITERATIONS = 3;
+
+// Perifocal basis of an orbit in scene coordinates (Y up, ecliptic in XZ).
+// P points at periapsis scaled by the semi-major axis, Q is 90 degrees ahead
+// scaled by the semi-minor axis, so position = P * (cos E - e) + Q * sin E.
+// Angles are in radians.
+void KeplerBasis(float a, float e, float inclination, float ascendingNode, float periapsis,
+                 float P[3], float Q[3]);
+
+// Eccentric anomaly for mean anomaly M in [-pi, pi], same solver as PropagateKepler
+float SolveKepler(float M, float e);
+
+// Classical orbital elements for a batch of bodies, structure-of-arrays
+class KeplerOrbits
+{
+public:
+    // Elements, angles in radians
+    std::vector<float> SemiMajorAxis;
+    std::vector<float> Eccentricity;
+    std::vector<float> Inclination;
+    std::vector<float> AscendingNode;
+    std::vector<float> Periapsis;   // argument of periapsis
+    std::vector<float> MeanAnomaly; // at time 0, reduced to [-pi, pi]
+    std::vector<float> MeanMotion;  // radians per unit time
+
+    // Perifocal basis from KeplerBasis
+    std::vector<float> Px, Py, Pz;
+    std::vector<float> Qx, Qy, Qz;
+
+    int Add(float a, float e, float inclination, float ascendingNode, float periapsis,
+            float meanAnomaly, float meanMotion);
+    int Count() const { return (int)SemiMajorAxis.size(); }
+    void Clear();
+};
+
+// Positions of bodies [first, first + count) at the given time, written to x/y/z[first...]
+void PropagateKepler(const KeplerOrbits &orbits, double time, int first, int count,
+                     float *x, float *y, float *z);
+
+// Same, forcing a specific instruction set; it is clamped to what the CPU supports
+void PropagateKepler(const KeplerOrbits &orbits, double time, int first, int count,
+                     float *x, float *y, float *z, SimdLevel level);
+
+#endif
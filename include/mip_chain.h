@@ -0,0 +1,22 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <vector>
+
+// Levels of a full mip chain down to 1x1
+int MipLevelCount(int width, int height);
+
+// 2x2 box filter of an RGB image into one of half the size, odd edges
+// repeat the last pixel
+void HalveImage(const unsigned char *src, int width, int height, unsigned char *dst);
+
+// Halves an RGB image in place until it is width x height. Returns false,
+// leaving the image at its last size, if the size is not reached exactly.
+bool ReduceImage(std::vector<unsigned char> &pixels, int &width, int &height, int targetWidth, int targetHeight);
+
+// Appends levels of an RGB image to out, the image itself first, stopping
+// after levelCount levels or at 1x1
+void AppendMipChain(std::vector<unsigned char> &out, std::vector<unsigned char> image, int width, int height,
+                    int levelCount);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef MIP_STREAMER_H
+#define MIP_STREAMER_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// GPU memory for the fine levels of streamed textures
+const size_t STREAMED_TEXTURE_BUDGET = 256 * 1024 * 1024;
+
+// Without a preview image, the first load stops at levels this wide
+const int STREAM_INITIAL_WIDTH = 512;
+
+// Frames a fine level stays resident after the last frame that needed it
+const long STREAM_RELEASE_FRAMES = 300;
+
+// Streams the mip chain of large textures in on demand. A texture starts
+// with its low mips only, taken from a smaller preview image when it has one.
+// Every frame the bodies using it report their size on screen, and once
+// texels would be magnified a background task decodes the source and builds
+// the finer levels, which are uploaded a few rows at a time, coarsest first,
+// lowering GL_TEXTURE_BASE_LEVEL as each one completes. Levels nobody needed
+// for a while, or that no longer fit the budget, are released again.
+// Must be created and updated on the thread that owns the GL context.
+class MipStreamer
+{
+public:
+    explicit MipStreamer(ThreadPool &pool, size_t budgetBytes = STREAMED_TEXTURE_BUDGET);
+    ~MipStreamer();
+
+    MipStreamer(const MipStreamer &) = delete;
+    MipStreamer &operator=(const MipStreamer &) = delete;
+
+    // The preview must be the source scaled down by a power of two; its
+    // levels are loaded right away. Returns -1 if the source can't be read.
+    int Add(const std::string &path, const std::string &preview = "");
+
+    // A body using the texture covers screenRadius pixels this frame
+    void Request(int texture, float screenRadius);
+
+    // Release unneeded levels, queue loads for finer ones and upload
+    // finished rows within ASSET_UPLOAD_BUDGET
+    void Update();
+
+    GLuint Texture(int texture) const { return entries[texture].Texture; }
+
+    // Width of the finest level that can be sampled, 0 before the low mips arrive
+    int ResidentWidth(int texture) const;
+
+    size_t MemoryUsage() const { return memoryUsage; }
+
+private:
+    struct Entry
+    {
+        std::string Path;
+        GLuint Texture = 0;
+        int Width = 0, Height = 0; // level 0
+        int Levels = 0;
+        int Kept = 0;        // finest level of the first load, never released
+        int Resident = 0;    // finest level uploaded, Levels until the first load
+        int Wanted = 0;      // finest level needed by this frame's requests
+        long LastRequested = -1;
+        long LastNeeded = 0; // frame the Resident level was last needed
+        bool Loading = false;
+        bool Failed = false;
+    };
+
+    // Levels First..Last of one texture, decoded by a pool task and then
+    // uploaded from Last down to First
+    struct Job
+    {
+        int Texture;
+        int First, Last;
+        std::string Source;
+        std::vector<std::vector<unsigned char>> Levels; // First at index 0
+        bool Done = false;
+        bool Failed = false;
+        // Upload progress, main thread only
+        int Level = -1;
+        int Row = 0;
+    };
+
+    void queue(int texture, int first, int last, const std::string &source);
+    size_t upload(Job &job, size_t budget);
+    void release(Entry &entry);
+    size_t levelBytes(const Entry &entry, int level) const;
+
+    ThreadPool &pool;
+    size_t budget;
+    std::vector<Entry> entries;
+    GLuint pixelBuffer;
+    size_t memoryUsage;
+    long frame;
+
+    std::vector<std::shared_ptr<Job>> jobs;
+    std::mutex mutex; // guards the Done flags of jobs
+    PendingTasks tasks;
+};
+
+#endif
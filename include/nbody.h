@@ -0,0 +1,93 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+enum NBodyIntegrator
+{
+    NBODY_LEAPFROG, // kick-drift-kick, one force evaluation per step
+    NBODY_YOSHIDA4  // fourth order composition of three leapfrog steps
+};
+
+// Barnes-Hut gravity simulation. State is kept in double precision
+// structure-of-arrays. Bodies with zero mass are test particles: they feel
+// gravity but are left out of the octree and attract nothing.
+class NBodySystem
+{
+public:
+    std::vector<double> X, Y, Z;
+    std::vector<double> VX, VY, VZ;
+    std::vector<double> AX, AY, AZ;
+    std::vector<double> Mass;
+    std::vector<double> PX, PY, PZ; // positions before the last step
+
+    double G;         // gravitational constant in simulation units
+    double Theta;     // opening angle, 0 degenerates to direct summation
+    double Softening; // Plummer softening length
+    int LeafSize;     // maximum number of bodies in an octree leaf
+    NBodyIntegrator Integrator;
+
+    NBodySystem();
+
+    int Add(double x, double y, double z, double vx, double vy, double vz, double mass);
+    int Count() const { return (int)X.size(); }
+    void Clear();
+
+    // Rebuild the octree and compute the acceleration of every body.
+    // The traversal is spread over the pool when one is given.
+    void ComputeForces(ThreadPool *pool);
+
+    // Advance by dt with the selected symplectic integrator. Positions before
+    // the step are kept so rendering can interpolate between the two states.
+    void Step(double dt, ThreadPool *pool);
+
+    // Position of body i blended between the previous step (alpha 0) and the current one (alpha 1)
+    void Interpolate(int i, double alpha, double &x, double &y, double &z) const
+    {
+        x = PX[i] + (X[i] - PX[i]) * alpha;
+        y = PY[i] + (Y[i] - PY[i]) * alpha;
+        z = PZ[i] + (Z[i] - PZ[i]) * alpha;
+    }
+
+    // Kinetic plus potential energy by direct summation, for checking drift
+    double Energy() const;
+
+    int NodeCount() const { return (int)nodes.size(); }
+
+private:
+    struct Node
+    {
+        double X, Y, Z; // center of mass
+        double Mass;
+        double Size;    // edge length of the cell
+        int First;      // range of sources covered by the node
+        int Count;
+        int Next;       // node to continue with once this subtree is done
+        bool Leaf;
+    };
+
+    void buildTree();
+    int buildNode(int begin, int end, int level, double size);
+    void accumulate(int self, double &ax, double &ay, double &az) const;
+    void kick(double dt);
+    void drift(double dt);
+    void leapfrog(double dt, ThreadPool *pool);
+
+    // Nodes in depth-first order: the first child of a node is the next entry
+    std::vector<Node> nodes;
+
+    // All bodies sorted along a Morton curve, used as traversal order
+    std::vector<std::pair<uint64_t, int>> order;
+
+    // Massive bodies in Morton order, copied for locality in the leaves
+    std::vector<uint64_t> sourceKey;
+    std::vector<int> sourceIndex;
+    std::vector<double> sx, sy, sz, sm;
+
+    bool forcesValid;
+};
+
+#endif
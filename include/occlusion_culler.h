@@ -0,0 +1,63 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <../external/glad/include/glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "sphere.h"
+
+#include <vector>
+
+// Bodies at least this large are drawn first and occlude the others
+const float OCCLUDER_RADIUS = 30.0f;
+
+// Icosphere subdivisions of the proxy spheres, coarse since they are never seen
+const int OCCLUSION_PROXY_SUBDIVISIONS = 1;
+
+// Skips bodies hidden behind the occluders using GL_ANY_SAMPLES_PASSED
+// queries on a low-poly proxy sphere. Proxies are drawn after the occluders
+// and before the bodies they stand for, with colour and depth writes off.
+// Results are read back a frame or more later, only once available, so the
+// GPU never stalls; a body whose last answered query saw no samples is
+// skipped until a newer one sees it again. Must be used on the GL thread.
+class OcclusionCuller
+{
+public:
+    explicit OcclusionCuller(int count);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller &) = delete;
+    OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+    // Start a frame: read back every query that has finished, never waiting
+    void Collect();
+
+    // False if the body's last answered query found it hidden. Bodies that
+    // went unqueried last frame, e.g. outside the frustum, count as visible.
+    bool Visible(int body) const;
+
+    // Proxies are drawn with shader, whose model matrix uniform is model.
+    // eye is the camera position in the same space as the bodies.
+    void BeginProxies(const Shader &shader, UniformHandle model, const glm::vec3 &eye);
+    void Query(int body, const glm::vec3 &center, float radius);
+    void EndProxies();
+
+    // Bodies found hidden at the last Collect
+    int Hidden() const { return hidden; }
+
+private:
+    std::vector<GLuint> queries;
+    std::vector<bool> pending;  // query issued and not read back yet
+    std::vector<bool> visible;  // last answered result
+    std::vector<long> lastQuery; // frame the body last asked for a query
+    long frame;
+    int hidden;
+
+    Sphere proxy;
+    const Shader *shader;
+    UniformHandle model;
+    glm::vec3 eye;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef ORBIT_KERNEL_H
+#define ORBIT_KERNEL_H
+
+#include "simd_math.h"
+
+// Structure-of-arrays input for a batch of bodies on circular orbits in the XZ plane
+struct OrbitBatch
+{
+    int Count;
+    const float *OrbitRadius;
+    const float *OrbitRate; // radians per unit of orbit time
+    const float *SpinRate;  // radians per unit of spin time
+    const float *TiltCos;   // cosine and sine of the axial tilt
+    const float *TiltSin;
+    const float *Scale;     // uniform scale applied to the mesh
+};
+
+// Writes one column-major 4x4 model matrix (16 floats) per body to instances.
+// Orbit and spin phases are formed as time * rate in double precision before
+// being reduced, so long uptimes do not lose precision.
+void EvaluateOrbits(const OrbitBatch &batch, double orbitTime, double spinTime, float *instances);
+
+// Same, forcing a specific instruction set; it is clamped to what the CPU supports
+void EvaluateOrbits(const OrbitBatch &batch, double orbitTime, double spinTime, float *instances, SimdLevel level);
+
+// Instruction set picked at startup for EvaluateOrbits
+SimdLevel OrbitKernelLevel();
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Linked program binaries are kept here, relative to the working directory
+const char PROGRAM_CACHE_DIRECTORY[] = "shader_cache";
+
+const char PROGRAM_CACHE_MAGIC[8] = {'S', 'S', 'P', 'R', 'O', 'G', '0', '1'};
+
+// File layout: this header, then Length bytes of driver binary
+struct ProgramCacheHeader
+{
+    char Magic[8];
+    uint64_t Key;
+    uint32_t Format; // binary format reported by the driver
+    uint32_t Length;
+};
+
+// Loads the ARB_get_program_binary entry points, which glad was generated
+// without. Caching stays off if the driver offers no binary format.
+void InitProgramCache(GLADloadproc load);
+
+bool ProgramCacheEnabled();
+
+// FNV-1a over the sources and GL_VENDOR, GL_RENDERER and GL_VERSION, so a
+// driver update or an edited shader never matches a stale binary
+uint64_t ProgramCacheKey(const std::vector<std::string> &sources);
+
+// Links program from the cached binary. False if there is none or the
+// driver rejects it, in which case the caller compiles from source.
+bool LoadProgramBinary(GLuint program, uint64_t key);
+
+// Stores a linked program. It must have been linked with
+// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+void SaveProgramBinary(GLuint program, uint64_t key);
+
+// Sets the retrievable hint before linking when caching is on
+void PrepareProgramBinary(GLuint program);
+
+#endif
@@ -4,43 +4,106 @@
 #include <../external/glad/include/glad/glad.h> // Correct and portable include for GLAD
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+// Location of an active uniform, resolved once. An invalid handle has location -1,
+// which GL silently ignores, so a uniform optimised out of a shader is harmless.
+struct UniformHandle
+{
+    GLint Location = -1;
+
+    bool Valid() const { return Location >= 0; }
+};
 
 class Shader
 {
 public:
     unsigned int ID;
 
-    // Constructor reads and builds the shader
-    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr);
+    // Constructor reads and builds the shader. Sources may #include "file"
+    // relative to themselves; permutation is a list of defines such as
+    // "INSTANCED" or "LIGHTS=4" added to every stage, so one source builds
+    // specialised variants, each with its own cached binary.
+    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr,
+           const std::string &permutation = std::string());
 
     // Use/activate the shader
     void Use() const;
 
-    // Utility uniform functions
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
+    // Preprocesses, compiles and links the program again without touching ID,
+    // reading loose files ahead of the asset pack if looseFiles is set.
+    // Returns 0 if it fails. files receives every file it was built from.
+    // May run on another thread whose context shares objects with this one's.
+    GLuint Compile(bool looseFiles, std::vector<std::string> &files) const;
+
+    // Replace the program with one from Compile, deleting the old one. Uniform
+    // values and block bindings start from their defaults again.
+    void Swap(GLuint program, const std::vector<std::string> &files);
+
+    // Files the program was built from, includes too
+    const std::vector<std::string> &Sources() const { return sources; }
+
+    // Look up a uniform in the table built at link time, no allocation.
+    // Resolve handles once and keep them for uniforms set every frame.
+    UniformHandle Uniform(const char *name) const;
 
-    void setVec2(const std::string &name, const glm::vec2 &value) const;
-    void setVec2(const std::string &name, float x, float y) const;
+    // Attach a uniform block to a binding point, ignored if the program lacks the block
+    void BindBlock(const char *name, GLuint binding) const;
 
-    void setVec3(const std::string &name, const glm::vec3 &value) const;
-    void setVec3(const std::string &name, float x, float y, float z) const;
+    // Utility uniform functions, by handle
+    void setBool(UniformHandle u, bool value) const { glUniform1i(u.Location, (int)value); }
+    void setInt(UniformHandle u, int value) const { glUniform1i(u.Location, value); }
+    void setFloat(UniformHandle u, float value) const { glUniform1f(u.Location, value); }
+    void setVec2(UniformHandle u, const glm::vec2 &value) const { glUniform2fv(u.Location, 1, &value[0]); }
+    void setVec2(UniformHandle u, float x, float y) const { glUniform2f(u.Location, x, y); }
+    void setVec3(UniformHandle u, const glm::vec3 &value) const { glUniform3fv(u.Location, 1, &value[0]); }
+    void setVec3(UniformHandle u, float x, float y, float z) const { glUniform3f(u.Location, x, y, z); }
+    void setVec4(UniformHandle u, const glm::vec4 &value) const { glUniform4fv(u.Location, 1, &value[0]); }
+    void setVec4(UniformHandle u, float x, float y, float z, float w) const { glUniform4f(u.Location, x, y, z, w); }
+    void setMat2(UniformHandle u, const glm::mat2 &mat) const { glUniformMatrix2fv(u.Location, 1, GL_FALSE, &mat[0][0]); }
+    void setMat3(UniformHandle u, const glm::mat3 &mat) const { glUniformMatrix3fv(u.Location, 1, GL_FALSE, &mat[0][0]); }
+    void setMat4(UniformHandle u, const glm::mat4 &mat) const { glUniformMatrix4fv(u.Location, 1, GL_FALSE, &mat[0][0]); }
 
-    void setVec4(const std::string &name, const glm::vec4 &value) const;
-    void setVec4(const std::string &name, float x, float y, float z, float w) const;
+    // Utility uniform functions, by name
+    void setBool(const char *name, bool value) const { setBool(Uniform(name), value); }
+    void setInt(const char *name, int value) const { setInt(Uniform(name), value); }
+    void setFloat(const char *name, float value) const { setFloat(Uniform(name), value); }
 
-    void setMat2(const std::string &name, const glm::mat2 &mat) const;
-    void setMat3(const std::string &name, const glm::mat3 &mat) const;
-    void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    void setVec2(const char *name, const glm::vec2 &value) const { setVec2(Uniform(name), value); }
+    void setVec2(const char *name, float x, float y) const { setVec2(Uniform(name), x, y); }
+
+    void setVec3(const char *name, const glm::vec3 &value) const { setVec3(Uniform(name), value); }
+    void setVec3(const char *name, float x, float y, float z) const { setVec3(Uniform(name), x, y, z); }
+
+    void setVec4(const char *name, const glm::vec4 &value) const { setVec4(Uniform(name), value); }
+    void setVec4(const char *name, float x, float y, float z, float w) const { setVec4(Uniform(name), x, y, z, w); }
+
+    void setMat2(const char *name, const glm::mat2 &mat) const { setMat2(Uniform(name), mat); }
+    void setMat3(const char *name, const glm::mat3 &mat) const { setMat3(Uniform(name), mat); }
+    void setMat4(const char *name, const glm::mat4 &mat) const { setMat4(Uniform(name), mat); }
 
     // Optional destructor
     ~Shader();
 
 private:
+    // Open-addressing hash table of active uniforms, filled after linking
+    struct UniformSlot
+    {
+        uint32_t Hash;
+        GLint Location;
+        std::string Name; // empty for a free slot
+    };
+    std::vector<UniformSlot> uniforms;
+
+    std::string vertexPath, fragmentPath, geometryPath, permutation;
+    std::vector<std::string> sources;
+
+    void buildUniformTable();
+
     // Utility function for checking shader compilation/linking errors.
-    void checkCompileErrors(GLuint shader, std::string type);
+    static void checkCompileErrors(GLuint shader, const std::string &type);
 };
 
 #endif // SHADER_H
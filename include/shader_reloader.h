@@ -0,0 +1,71 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <../external/glad/include/glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "shader.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rebuilds shaders whose files change while the app runs. Changes are seen
+// through inotify on the directories of the watched files; the programs are
+// compiled and linked on a worker thread with a hidden context that shares
+// objects with the window's, so the render loop never waits on the compiler.
+// A rebuilt program replaces the old one in Update only once it has linked,
+// so a broken edit leaves the running program in place.
+// Linux only, elsewhere nothing is watched.
+class ShaderReloader
+{
+public:
+    // Must be created and updated on the thread that owns window's context
+    explicit ShaderReloader(GLFWwindow *window);
+    ~ShaderReloader();
+
+    ShaderReloader(const ShaderReloader &) = delete;
+    ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+    // The shader must outlive the reloader
+    void Watch(Shader &shader);
+
+    // Queue rebuilds for changed files and swap in finished programs.
+    // Returns true if any program was replaced, whose uniforms and block
+    // bindings then need setting again.
+    bool Update();
+
+    // Join the worker and destroy the hidden context; must run before
+    // glfwTerminate, with the window's context still current
+    void Stop();
+
+    bool Enabled() const { return context != NULL; }
+
+private:
+    struct Build
+    {
+        Shader *Target;
+        GLuint Program;
+        std::vector<std::string> Files;
+    };
+
+    void watchDirectory(const std::string &directory);
+    void run();
+
+    GLFWwindow *context; // hidden, current on the worker thread
+    int notify;          // inotify descriptor, -1 when not watching
+    std::map<int, std::string> directories; // watch descriptor to directory
+    std::vector<Shader *> shaders;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;               // guarded by mutex
+    std::vector<Shader *> queue; // guarded by mutex
+    std::vector<Build> built;    // guarded by mutex
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+// Fixed-step simulation clock driven by a variable frame rate.
+// Real time is accumulated in double precision and handed out in whole
+// steps; the remainder is exposed as an interpolation factor so rendering
+// can blend between the last two simulated states.
+class SimClock
+{
+public:
+    double StepSize;   // simulation time per step
+    int MaxSteps;      // steps allowed per frame before time is dropped
+    double Speed;      // simulation time per second of real time
+
+    SimClock(double stepSize, double speed, int maxSteps = 4);
+
+    // Feed the current real time in seconds, returns how many fixed steps to run.
+    // If the frame took too long the backlog beyond MaxSteps is discarded,
+    // which slows the simulation down instead of letting the cost spiral.
+    int Advance(double realTime);
+
+    // Simulation time of the most recent step
+    double Time() const { return time; }
+
+    // Blend factor in [0, 1) between the previous and the most recent step
+    double Alpha() const { return accumulator / StepSize; }
+
+    // Time that matches the interpolated state, for quantities evaluated analytically
+    double RenderTime() const { return time - StepSize + accumulator; }
+
+    // Restart at the given simulation time, e.g. after switching modes.
+    // Real time that passed before the next Advance is not simulated.
+    void Reset(double simTime);
+
+private:
+    double time;
+    double accumulator;
+    double lastReal;
+    bool started;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+// Polynomial sin/cos and phase reduction shared by the batched kernels.
+// Every variant evaluates the same Cephes polynomials, so the scalar,
+// SSE2 and AVX2 paths produce matching results.
+
+#include <cmath>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define SIMD_X86 1
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_X86 0
+#endif
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+// Best instruction set supported by the running CPU
+SimdLevel DetectSimdLevel();
+const char *SimdLevelName(SimdLevel level);
+
+namespace simd
+{
+const double TWO_PI = 6.283185307179586476925;
+const double INV_TWO_PI = 0.159154943091895335768;
+
+// pi/2 split into three parts for exact range reduction (Cody-Waite)
+const float DP1 = 1.5703125f;
+const float DP2 = 4.837512969970703125e-4f;
+const float DP3 = 7.54978995489188216e-8f;
+const float TWO_OVER_PI = 0.636619772367581343076f;
+
+const float S0 = -1.6666654611e-1f;
+const float S1 = 8.3321608736e-3f;
+const float S2 = -1.9515295891e-4f;
+const float C0 = 4.166664568298827e-2f;
+const float C1 = -1.388731625493765e-3f;
+const float C2 = 2.443315711809948e-5f;
+
+// Wrap an angle of any magnitude into [-pi, pi] in double precision
+inline float ReducePhase(double x)
+{
+    return (float)(x - std::nearbyint(x * INV_TWO_PI) * TWO_PI);
+}
+
+// sin and cos of x, accurate to a few ulp for |x| <= pi
+inline void SinCos(float x, float &s, float &c)
+{
+    int j = (int)std::nearbyint(x * TWO_OVER_PI);
+    float fj = (float)j;
+    float y = ((x - fj * DP1) - fj * DP2) - fj * DP3;
+    float z = y * y;
+
+    float ps = ((S2 * z + S1) * z + S0) * z * y + y;
+    float pc = ((C2 * z + C1) * z + C0) * z * z - 0.5f * z + 1.0f;
+
+    int q = j & 3;
+    float sv = (q & 1) ? pc : ps;
+    float cv = (q & 1) ? ps : pc;
+    s = (q & 2) ? -sv : sv;
+    c = ((q + 1) & 2) ? -cv : cv;
+}
+
+#if SIMD_X86
+SIMD_TARGET_SSE2 inline __m128d ReducePhase2(__m128d x)
+{
+    // adding 1.5 * 2^52 rounds to the nearest integer without SSE4.1
+    const __m128d magic = _mm_set1_pd(6755399441055744.0);
+    __m128d n = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(INV_TWO_PI)), magic), magic);
+    return _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(TWO_PI)));
+}
+
+// Reduce time * rate for four bodies, the product is formed in double precision
+SIMD_TARGET_SSE2 inline __m128 Phase4(const float *rate, double time)
+{
+    __m128 r = _mm_loadu_ps(rate);
+    __m128d t = _mm_set1_pd(time);
+    __m128d lo = ReducePhase2(_mm_mul_pd(_mm_cvtps_pd(r), t));
+    __m128d hi = ReducePhase2(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(r, r)), t));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+SIMD_TARGET_SSE2 inline void SinCos4(__m128 x, __m128 &s, __m128 &c)
+{
+    __m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+    __m128 fj = _mm_cvtepi32_ps(j);
+    __m128 y = _mm_sub_ps(x, _mm_mul_ps(fj, _mm_set1_ps(DP1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(DP2)));
+    y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(DP3)));
+    __m128 z = _mm_mul_ps(y, y);
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(S2), z), _mm_set1_ps(S1));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(S0));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), y), y);
+
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(C2), z), _mm_set1_ps(C1));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(C0));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+    __m128i q = _mm_and_si128(j, _mm_set1_epi32(3));
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sv = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+    __m128 cv = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+
+    // bit 1 of the quadrant moved into the sign bit
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128i q1 = _mm_add_epi32(q, _mm_set1_epi32(1));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q1, _mm_set1_epi32(2)), 30));
+    s = _mm_xor_ps(sv, sinSign);
+    c = _mm_xor_ps(cv, cosSign);
+}
+
+SIMD_TARGET_AVX2 inline __m256d ReducePhase4(__m256d x)
+{
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(INV_TWO_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    return _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(TWO_PI)));
+}
+
+// Reduce time * rate for eight bodies, the product is formed in double precision
+SIMD_TARGET_AVX2 inline __m256 Phase8(const float *rate, double time)
+{
+    __m256 r = _mm256_loadu_ps(rate);
+    __m256d t = _mm256_set1_pd(time);
+    __m256d lo = ReducePhase4(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(r)), t));
+    __m256d hi = ReducePhase4(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(r, 1)), t));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+}
+
+SIMD_TARGET_AVX2 inline void SinCos8(__m256 x, __m256 &s, __m256 &c)
+{
+    __m256i j = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)));
+    __m256 fj = _mm256_cvtepi32_ps(j);
+    __m256 y = _mm256_sub_ps(x, _mm256_mul_ps(fj, _mm256_set1_ps(DP1)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(fj, _mm256_set1_ps(DP2)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(fj, _mm256_set1_ps(DP3)));
+    __m256 z = _mm256_mul_ps(y, y);
+
+    __m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(S2), z), _mm256_set1_ps(S1));
+    ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(S0));
+    ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), y), y);
+
+    __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(C2), z), _mm256_set1_ps(C1));
+    pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(C0));
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+    pc = _mm256_add_ps(_mm256_sub_ps(pc, _mm256_mul_ps(_mm256_set1_ps(0.5f), z)), _mm256_set1_ps(1.0f));
+
+    __m256i q = _mm256_and_si256(j, _mm256_set1_epi32(3));
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sv = _mm256_blendv_ps(ps, pc, swap);
+    __m256 cv = _mm256_blendv_ps(pc, ps, swap);
+
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256i q1 = _mm256_add_epi32(q, _mm256_set1_epi32(1));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q1, _mm256_set1_epi32(2)), 30));
+    s = _mm256_xor_ps(sv, sinSign);
+    c = _mm256_xor_ps(cv, cosSign);
+}
+#endif
+} // namespace simd
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SOLAR_SYSTEM_H
+#define SOLAR_SYSTEM_H
+
+#include "body_registry.h"
+
+// Orbital and physical data of every body in the scene. Render data is kept
+// out of the table so headless tools can share it with the renderer.
+// Parents come before their satellites.
+extern const BodyDesc SOLAR_SYSTEM[];
+extern const int SOLAR_SYSTEM_COUNT;
+
+#endif
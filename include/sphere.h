@@ -2,26 +2,29 @@
 #define SPHERE_H
 
 #include <../external/glad/include/glad/glad.h>
-#include <vector>
+
+#include "sphere_mesh.h"
 
 class Sphere
 {
 private:
-    std::vector<float> sphere_vertices;
-    std::vector<int> sphere_indices;
     GLuint VBO, VAO, EBO;
-    float radius;
-    int sectorCount;
-    int stackCount;
+    GLsizei indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT whenever the vertices fit
 
-    void generateVertices();
-    void generateIndices();
-    void setupBuffers();
+    void setupBuffers(const SphereMesh &mesh);
 
 public:
     Sphere(float r, int sectors, int stacks);
+    explicit Sphere(const SphereMesh &mesh);
     ~Sphere();
     void Draw();
+
+    // Feed per-instance attributes from two buffers: a column-major mat4 model
+    // matrix per instance at locations 2-5 and a vec3 of texture layers at location 6,
+    // starting at instance first
+    void SetInstanceBuffers(GLuint models, GLuint layers, int first = 0);
+    void DrawInstanced(GLsizei instances);
 };
 
 #endif
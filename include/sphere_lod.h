@@ -0,0 +1,40 @@
+#ifndef SPHERE_LOD_H
+#define SPHERE_LOD_H
+
+#include "sphere.h"
+
+#include <memory>
+#include <vector>
+
+// Edges around the equator of the unit sphere levels, coarsest first. The
+// levels are cube spheres with a quarter of that many divisions per face,
+// kept even so a vertex sits on each pole.
+const int SPHERE_LOD_EDGES[] = {8, 16, 24, 32, 48, 64, 112, 184};
+const int SPHERE_LOD_LEVELS = sizeof(SPHERE_LOD_EDGES) / sizeof(SPHERE_LOD_EDGES[0]);
+
+// Longest silhouette edge allowed on screen, in pixels
+const float SPHERE_LOD_EDGE_PIXELS = 6.0f;
+
+// A body drops to a coarser level only once it is this much smaller than
+// the size that made it switch up, so it doesn't flicker between two
+const float SPHERE_LOD_HYSTERESIS = 1.3f;
+
+// Unit spheres at SPHERE_LOD_LEVELS tessellations, built once. Every body
+// picks the coarsest one whose silhouette edges stay under
+// SPHERE_LOD_EDGE_PIXELS at its size on screen.
+class SphereLod
+{
+public:
+    SphereLod();
+
+    int Levels() const { return (int)levels.size(); }
+    Sphere &Level(int level) { return *levels[level]; }
+
+    // Level for a body covering screenRadius pixels that used current last frame
+    int Select(float screenRadius, int current) const;
+
+private:
+    std::vector<std::unique_ptr<Sphere>> levels;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SPHERE_MESH_H
+#define SPHERE_MESH_H
+
+#include <vector>
+
+// Entries of the post-transform vertex cache the triangle order is tuned for
+const int VERTEX_CACHE_SIZE = 32;
+
+// Triangle list of a sphere around the origin, x y z s t per vertex. s runs
+// around the z axis from +x and t from the north pole down, as in the
+// equirectangular planet maps; the triangles wind counter-clockwise seen
+// from outside.
+struct SphereMesh
+{
+    std::vector<float> Vertices;
+    std::vector<unsigned int> Indices;
+
+    int VertexCount() const { return (int)Vertices.size() / 5; }
+};
+
+// Latitude/longitude grid, crowded with thin triangles towards the poles
+SphereMesh GenerateUVSphere(float radius, int sectors, int stacks);
+
+// Icosahedron with every triangle split in four, subdivisions times.
+// 20 * 4^subdivisions triangles of nearly the same size.
+SphereMesh GenerateIcosphere(float radius, int subdivisions);
+
+// Cube with divisions x divisions quads per face, projected at equal angles
+// so the equator is 4 * divisions edges of the same length
+SphereMesh GenerateCubeSphere(float radius, int divisions);
+
+// Reorders the triangles for the vertex cache with Forsyth's linear-speed
+// algorithm, then the vertices in the order the triangles first use them.
+// The generators above already return optimized meshes.
+void OptimizeSphereMesh(SphereMesh &mesh);
+
+// Distance from the origin to the closest triangle plane
+float InscribedRadius(const SphereMesh &mesh);
+
+#endif
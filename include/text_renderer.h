@@ -0,0 +1,86 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <../external/glad/include/glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Screen corner a label is positioned from
+enum TextAnchor
+{
+    TEXT_BOTTOM_LEFT,
+    TEXT_TOP_LEFT,
+    TEXT_TOP_RIGHT,
+    TEXT_BOTTOM_RIGHT
+};
+
+// HUD text drawn from a single glyph atlas. Glyphs come from stb_easy_font,
+// rasterised once at startup.
+//
+// Labels are retained: each is laid out once into a persistent vertex buffer
+// and only laid out again when its text or the viewport changes.
+// Flush() draws the visible labels with a single call.
+class TextRenderer
+{
+public:
+    TextRenderer();
+    ~TextRenderer();
+
+    // Create a label at (x, y) pixels from the anchor corner towards the middle
+    // of the screen, y being the baseline of the first line. A scale of 1 makes
+    // capitals about 35 pixels tall. Returns its id.
+    int CreateLabel(const std::string &text, TextAnchor anchor, float x, float y, float scale, const glm::vec3 &color);
+
+    // Change the text of a label, it is only laid out again if the text differs
+    void SetLabelText(int label, const std::string &text);
+    void SetLabelVisible(int label, bool visible);
+
+    // Size of the screen in pixels, anchored labels move when it changes
+    void SetViewport(float width, float height);
+
+    // Width in pixels of a string at the given scale
+    float Width(const std::string &text, float scale) const;
+
+    // Draw the visible labels
+    void Flush(const Shader &shader);
+
+private:
+    struct Vertex
+    {
+        float X, Y;
+        float U, V;
+        unsigned char Color[4];
+    };
+
+    struct Label
+    {
+        std::string Text;
+        TextAnchor Anchor;
+        float X, Y;
+        float Scale;
+        glm::vec3 Color;
+        bool Visible;
+        GLint First; // range in the label buffer
+        GLsizei Count;
+    };
+
+    GLuint atlas;
+    unsigned char advance[96]; // per printable ASCII character, in font units
+
+    GLuint labelVAO, labelVBO;
+    std::vector<Label> labels;
+    bool labelsDirty;
+    float viewportWidth, viewportHeight;
+    std::vector<GLint> drawFirst;
+    std::vector<GLsizei> drawCount;
+
+    void buildAtlas();
+    void layout(std::vector<Vertex> &out, const std::string &text, float x, float y, float scale, const glm::vec3 &color) const;
+    void layoutLabels();
+};
+
+#endif
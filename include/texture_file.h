@@ -0,0 +1,60 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Baked texture written by tools/bake_assets: one image in S3TC block
+// compression with its whole mip chain precomputed down to 1x1.
+//
+// File layout (little endian):
+//   TextureFileHeader
+//   TextureFileLevel[LevelCount], level 0 first
+//   block data, each level at its Offset from the start of the file
+
+const char TEXTURE_FILE_MAGIC[8] = {'S', 'S', 'T', 'E', 'X', 'B', 'C', '1'};
+
+// Baked files sit next to their source image with this extension
+const char TEXTURE_FILE_EXTENSION[] = ".ctex";
+
+enum TextureFileFormat
+{
+    TEXTURE_BC1 = 1, // DXT1, RGB, 8 bytes per 4x4 block
+    TEXTURE_BC3 = 3  // DXT5, RGBA, 16 bytes per 4x4 block
+};
+
+struct TextureFileHeader
+{
+    char Magic[8];
+    uint32_t Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t LevelCount;
+};
+
+struct TextureFileLevel
+{
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+inline uint32_t TextureBlockBytes(uint32_t format)
+{
+    return format == TEXTURE_BC1 ? 8 : 16;
+}
+
+// Bytes of one level, partial blocks at the edges count as whole ones
+inline uint32_t TextureLevelSize(uint32_t format, uint32_t width, uint32_t height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * TextureBlockBytes(format);
+}
+
+// Path of the baked file for a source image, e.g. planets/2k_sun.jpg -> planets/2k_sun.ctex
+std::string BakedTexturePath(const std::string &path);
+
+// Checks the header and level table against the file size.
+// Returns false and prints a message if the file is malformed.
+bool ValidateTextureFile(const unsigned char *data, size_t size, const std::string &path);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "asset_loader.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A GL texture shared between everyone who asked for the same images
+struct Texture
+{
+    GLuint ID;
+    GLenum Target;
+};
+
+// The texture is deleted when the last reference is released
+typedef std::shared_ptr<const Texture> TextureRef;
+
+// Hands out shared textures keyed by the canonical paths of their images and
+// their sampler settings, so each file is decoded and uploaded once however
+// many places use it. Loading goes through the AssetLoader, so the texture
+// holds a placeholder until its images arrive.
+// Every TextureRef must be released before the manager is destroyed.
+class TextureManager
+{
+public:
+    explicit TextureManager(AssetLoader &loader);
+
+    TextureRef Texture2D(const std::string &path, const TextureParams &params = SURFACE_TEXTURE);
+    TextureRef TextureArray(const std::vector<std::string> &paths, const TextureParams &params = SURFACE_TEXTURE);
+    TextureRef Cubemap(const std::vector<std::string> &faces, const TextureParams &params = SKY_TEXTURE);
+
+    // Textures currently alive
+    int Count() const { return (int)cache.size(); }
+
+private:
+    TextureRef acquire(GLenum target, const std::vector<std::string> &paths, const TextureParams &params);
+    void release(const std::string &key, Texture *texture);
+
+    AssetLoader &loader;
+    std::unordered_map<std::string, std::weak_ptr<const Texture>> cache;
+};
+
+#endif
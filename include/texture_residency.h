@@ -0,0 +1,107 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <../external/glad/include/glad/glad.h>
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Lower resolution layers are this many times smaller in each direction
+const int RESIDENCY_BASE_DIVISOR = 4;
+
+// GPU memory for the planet surface textures, including their mip chains
+const size_t PLANET_TEXTURE_BUDGET = 48 * 1024 * 1024;
+
+// Keeps the planet surfaces in two texture arrays under a memory budget.
+// The base array has a layer for every texture at 1/RESIDENCY_BASE_DIVISOR of
+// the full size, which is all a body needs until it gets close; the detail
+// array holds as many full-size layers as the rest of the budget allows and
+// hands them to the requested bodies that cover the most pixels, evicting the
+// least recently wanted one when it runs out. Nothing is loaded until a
+// texture is first requested. Baked BC1 files from tools/bake_assets are
+// copied in as they are when every texture has one and the driver supports
+// S3TC; otherwise images decode and mip on the thread pool into RGB8 layers.
+// Must be created and updated on the thread that owns the GL context.
+class TextureResidency
+{
+public:
+    // Every image must be width x height or a power of two multiple of it
+    TextureResidency(ThreadPool &pool, const std::vector<std::string> &paths, int width, int height,
+                     size_t budgetBytes = PLANET_TEXTURE_BUDGET);
+    ~TextureResidency();
+
+    TextureResidency(const TextureResidency &) = delete;
+    TextureResidency &operator=(const TextureResidency &) = delete;
+
+    // A texture is visible this frame on a body covering screenRadius pixels
+    void Request(int texture, float screenRadius);
+
+    // Hand out detail layers to this frame's requests, queue the loads they
+    // need and upload finished ones within the per-frame byte budget
+    void Update();
+
+    // Layers to sample: base is a grey placeholder until loaded, detail is -1
+    // while the texture has no resident full-size layer
+    float BaseLayer(int texture) const;
+    float DetailLayer(int texture) const;
+    float PlaceholderLayer() const { return (float)entries.size(); }
+
+    GLuint BaseTexture() const { return baseArray; }
+    GLuint DetailTexture() const { return detailArray ? detailArray : baseArray; }
+
+    int DetailSlots() const { return (int)slots.size(); }
+    size_t MemoryUsage() const { return memoryUsage; }
+
+private:
+    struct Entry
+    {
+        std::string Path;
+        bool BaseLoaded = false;
+        bool BaseLoading = false;
+        int Slot = -1; // detail layer owned by this texture
+        bool DetailLoaded = false;
+        bool Failed = false;       // image is missing or has the wrong size, not retried
+        int BakedLevel = -1;       // level of the baked file at the detail size
+        float ScreenRadius = 0.0f; // largest request this frame
+        long LastWanted = -1;      // frame this texture last wanted its detail layer
+        long LastRequested = -1;
+    };
+
+    // Decoded mip chain on its way to a layer, filled in by a pool task
+    struct Job
+    {
+        int Texture;
+        int Slot; // -1 for the base array
+        int Width, Height;
+        std::vector<unsigned char> Pixels; // RGB or BC1 levels back to back, level 0 first
+        bool Done = false;
+        bool Failed = false;
+    };
+
+    void queue(int texture, int slot);
+    void upload(const Job &job);
+
+    ThreadPool &pool;
+    std::vector<Entry> entries;
+    std::vector<int> slots; // owning texture per detail layer, -1 if free
+    int width, height;
+    int baseWidth, baseHeight;
+    int levels, baseLevels;
+    int baseShift;   // levels from the detail size down to the base size
+    bool compressed; // both arrays are BC1
+    GLuint baseArray, detailArray;
+    GLuint pixelBuffer;
+    size_t memoryUsage;
+    long frame;
+
+    std::vector<std::shared_ptr<Job>> jobs;
+    std::mutex mutex; // guards the Done flags of jobs
+    PendingTasks tasks;
+};
+
+#endif
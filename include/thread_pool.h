@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by the simulation and asset loading
+class ThreadPool
+{
+public:
+    // threads <= 0 uses one worker per hardware thread
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int Size() const { return (int)workers.size(); }
+
+    // Queue a task to run on one of the workers
+    void Submit(std::function<void()> task);
+
+    // Run fn(begin, end) over [0, count) in chunks of at most grain items and
+    // wait for all of them. The calling thread works on chunks as well, so this
+    // completes even while the workers are busy with queued tasks.
+    void ParallelFor(int count, int grain, const std::function<void(int, int)> &fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+// Tasks an object has in flight on a pool. The object waits for them in its
+// destructor, before the state they write to goes away.
+class PendingTasks
+{
+public:
+    PendingTasks() : running(0) {}
+    ~PendingTasks() { Wait(); }
+
+    // Queue task on pool and count it until it returns
+    void Submit(ThreadPool &pool, std::function<void()> task);
+
+    // Block until every submitted task has returned
+    void Wait();
+
+private:
+    std::mutex mutex;
+    std::condition_variable finished;
+    int running;
+};
+
+#endif
@@ -1,11 +1,16 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 0) in vec2 position; // pixels from the bottom-left corner
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec4 aColor;
+
 out vec2 TexCoords;
+out vec4 TextColor;
 
-uniform mat4 projection;
+#include "frame_constants.glsl"
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-    TexCoords = vertex.zw;
-}  
\ No newline at end of file
+    gl_Position = screenProjection * vec4(position, 0.0, 1.0);
+    TexCoords = aTexCoord;
+    TextColor = aColor;
+}
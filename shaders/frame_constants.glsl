@@ -0,0 +1,14 @@
+// Mirrors FrameConstants in include/frame_constants.h
+#ifndef FRAME_CONSTANTS_GLSL
+#define FRAME_CONSTANTS_GLSL
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;             // camera view, scene rotation included
+    mat4 projection;
+    mat4 skyView;          // camera rotation only
+    mat4 screenProjection; // orthographic, in pixels
+    vec4 viewport;         // width, height, 1 / width, 1 / height
+};
+
+#endif
@@ -0,0 +1,9 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+#include "frame_constants.glsl"
+
+void main()
+{
+    gl_Position = projection * view * vec4(position, 1.0);
+}
@@ -1,12 +0,0 @@
-#version 330 core
-
-out vec4 color;
-
-in vec2 texCoord;
-
-uniform sampler2D ourTexture;
-
-void main()
-{
-	color = texture(ourTexture, texCoord);
-}
\ No newline at end of file
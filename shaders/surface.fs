@@ -0,0 +1,29 @@
+#version 330 core
+
+out vec4 color;
+
+in vec2 texCoord;
+
+#ifdef INSTANCED
+flat in vec3 layers;
+
+uniform sampler2DArray planetTextures; // reduced size, every body
+uniform sampler2DArray detailTextures; // full size, bodies close to the camera
+uniform sampler2D streamedTexture;     // high resolution, the largest body on screen
+#else
+uniform vec3 flatColor; // orbit lines, rings and occlusion proxies
+#endif
+
+void main()
+{
+#ifdef INSTANCED
+    if (layers.z >= 0.0)
+        color = texture(streamedTexture, texCoord);
+    else if (layers.y >= 0.0)
+        color = texture(detailTextures, vec3(texCoord, layers.y));
+    else
+        color = texture(planetTextures, vec3(texCoord, layers.x));
+#else
+    color = vec4(flatColor, 1.0);
+#endif
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 aTexCoord;
+
+#ifdef INSTANCED
+layout (location = 2) in mat4 instanceModel;
+layout (location = 6) in vec3 instanceLayers; // base layer, detail layer or -1, streamed or -1
+
+flat out vec3 layers;
+#else
+uniform mat4 model;
+#endif
+
+#include "frame_constants.glsl"
+
+out vec2 texCoord;
+
+void main()
+{
+#ifdef INSTANCED
+    gl_Position = projection * view * instanceModel * vec4(position, 1.0);
+    layers = instanceLayers;
+#else
+    gl_Position = projection * view * model * vec4(position, 1.0);
+#endif
+    texCoord = aTexCoord;
+}
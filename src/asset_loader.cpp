@@ -0,0 +1,416 @@
+#include "asset_loader.h"
+
+#include "thread_pool.h"
+#include "texture_file.h"
+#include "asset_pack.h"
+
+#include <stb_image.h>
+
+#include <cstring>
+#include <iostream>
+
+// Shown until the real image is uploaded: grey for surfaces, black for the sky
+static const unsigned char SURFACE_PLACEHOLDER[3] = {128, 128, 128};
+static const unsigned char SKY_PLACEHOLDER[3] = {0, 0, 0};
+
+static GLenum pixelFormat(int channels)
+{
+    if (channels == 1)
+        return GL_RED;
+    if (channels == 4)
+        return GL_RGBA;
+    return GL_RGB;
+}
+
+static bool usesMipmaps(GLint filter)
+{
+    return filter != GL_NEAREST && filter != GL_LINEAR;
+}
+
+AssetLoader::AssetLoader(ThreadPool &pool)
+    : pool(pool), compressedTextures(false), decoding(0)
+{
+    glGenBuffers(1, &pixelBuffer);
+    compressedTextures = CompressedTexturesSupported();
+    if (!compressedTextures)
+        std::cout << "S3TC is not supported, baked textures are ignored" << std::endl;
+}
+
+AssetLoader::~AssetLoader()
+{
+    // Decode tasks write into assets and signal through this object
+    std::unique_lock<std::mutex> lock(mutex);
+    decoded.wait(lock, [this]() { return decoding == 0; });
+    for (const std::shared_ptr<Asset> &asset : assets)
+    {
+        for (Image &image : asset->Images)
+            stbi_image_free(image.Pixels);
+    }
+    lock.unlock();
+
+    glDeleteBuffers(1, &pixelBuffer);
+}
+
+GLuint AssetLoader::LoadTexture(const std::string &path, const TextureParams &params)
+{
+    return queue(GL_TEXTURE_2D, {path}, params);
+}
+
+GLuint AssetLoader::LoadTextureArray(const std::vector<std::string> &paths, const TextureParams &params)
+{
+    TextureParams arrayParams = params;
+    if (arrayParams.Components == 0)
+        arrayParams.Components = 3;
+    return queue(GL_TEXTURE_2D_ARRAY, paths, arrayParams);
+}
+
+GLuint AssetLoader::LoadCubemap(const std::vector<std::string> &faces, const TextureParams &params)
+{
+    return queue(GL_TEXTURE_CUBE_MAP, faces, params);
+}
+
+void AssetLoader::Cancel(GLuint texture)
+{
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        if (assets[i]->Texture == texture)
+        {
+            // Still decoding tasks hold the asset, Update frees it once they finish
+            assets[i]->Texture = 0;
+            return;
+        }
+    }
+}
+
+bool AssetLoader::Loaded(GLuint texture) const
+{
+    for (const std::shared_ptr<Asset> &asset : assets)
+    {
+        if (asset->Texture == texture)
+            return false;
+    }
+    return true;
+}
+
+GLuint AssetLoader::queue(GLenum target, const std::vector<std::string> &paths, const TextureParams &params)
+{
+    std::shared_ptr<Asset> asset = std::make_shared<Asset>();
+    asset->Target = target;
+    asset->Params = params;
+    asset->Baked = compressedTextures;
+    for (const std::string &path : paths)
+    {
+        if (!AssetExists(BakedTexturePath(path)))
+            asset->Baked = false;
+    }
+    asset->Paths = paths;
+    asset->Images.resize(paths.size());
+    asset->Remaining = (int)paths.size();
+
+    // 1x1 placeholder, complete without mipmaps so it samples with the final filters
+    glGenTextures(1, &asset->Texture);
+    glBindTexture(target, asset->Texture);
+    if (target == GL_TEXTURE_CUBE_MAP)
+    {
+        for (int i = 0; i < 6; i++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, SKY_PLACEHOLDER);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, params.Wrap);
+    }
+    else if (target == GL_TEXTURE_2D_ARRAY)
+    {
+        std::vector<unsigned char> layers(paths.size() * 3);
+        for (size_t i = 0; i < layers.size(); i++)
+            layers[i] = SURFACE_PLACEHOLDER[i % 3];
+        glTexImage3D(target, 0, GL_RGB8, 1, 1, (GLsizei)paths.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, layers.data());
+    }
+    else
+        glTexImage2D(target, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, SURFACE_PLACEHOLDER);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, params.Wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, params.Wrap);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, params.MinFilter);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, params.MagFilter);
+    glBindTexture(target, 0);
+
+    // One task per image, so array layers and cube faces decode in parallel
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoding += (int)paths.size();
+    }
+    for (size_t i = 0; i < paths.size(); i++)
+        submit(asset, i);
+
+    assets.push_back(asset);
+    return asset->Texture;
+}
+
+// Pool task loading image i: the baked file when the asset uses them,
+// otherwise or if it fails to open or validate the source image
+void AssetLoader::submit(const std::shared_ptr<Asset> &asset, size_t i)
+{
+    pool.Submit([this, asset, i]() {
+        Image &image = asset->Images[i];
+        if (asset->Baked)
+        {
+            if (image.Baked.Open(asset->Paths[i]))
+            {
+                image.Width = (int)image.Baked.Header()->Width;
+                image.Height = (int)image.Baked.Header()->Height;
+            }
+            else
+                std::cout << "Baked texture " << BakedTexturePath(asset->Paths[i]) << " is unusable, decoding "
+                          << asset->Paths[i] << std::endl;
+        }
+        if (!image.Baked.Data())
+        {
+            image.Pixels = DecodeImage(asset->Paths[i], image.Width, image.Height, image.Channels,
+                                       asset->Params.Components);
+            if (asset->Params.Components > 0)
+                image.Channels = asset->Params.Components;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        asset->Remaining--;
+        decoding--;
+        decoded.notify_all();
+    });
+}
+
+// Every image of a baked asset mapped a valid file, all in the same format and size
+bool AssetLoader::bakedUsable(const Asset &asset) const
+{
+    const TextureFileHeader *first = asset.Images[0].Baked.Header();
+    for (size_t i = 0; i < asset.Images.size(); i++)
+    {
+        const TextureFileHeader *header = asset.Images[i].Baked.Header();
+        if (!first || !header)
+            return false;
+        if (header->Format != first->Format || header->Width != first->Width || header->Height != first->Height ||
+            header->LevelCount != first->LevelCount)
+        {
+            std::cout << "Baked texture " << BakedTexturePath(asset.Paths[i]) << " does not match "
+                      << BakedTexturePath(asset.Paths[0]) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetLoader::Update(size_t budgetBytes)
+{
+    size_t uploaded = 0;
+    for (size_t i = 0; i < assets.size() && uploaded < budgetBytes;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (assets[i]->Remaining > 0)
+            {
+                i++;
+                continue;
+            }
+        }
+
+        // When a baked file can't be used the whole asset falls back to its
+        // source images, decoding those that haven't been yet
+        Asset &asset = *assets[i];
+        if (asset.Baked && asset.Texture != 0 && !bakedUsable(asset))
+        {
+            asset.Baked = false;
+            std::vector<size_t> missing;
+            for (size_t j = 0; j < asset.Images.size(); j++)
+            {
+                asset.Images[j].Baked.Close();
+                if (!asset.Images[j].Pixels)
+                    missing.push_back(j);
+            }
+            if (!missing.empty())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    asset.Remaining = (int)missing.size();
+                    decoding += (int)missing.size();
+                }
+                for (size_t j : missing)
+                    submit(assets[i], j);
+                i++;
+                continue;
+            }
+        }
+
+        uploaded += upload(asset);
+        assets.erase(assets.begin() + i);
+    }
+}
+
+void AssetLoader::Finish()
+{
+    while (!assets.empty())
+    {
+        {
+            // Sleep until at least one asset is fully decoded
+            std::unique_lock<std::mutex> lock(mutex);
+            decoded.wait(lock, [this]() {
+                for (const std::shared_ptr<Asset> &asset : assets)
+                {
+                    if (asset->Remaining == 0)
+                        return true;
+                }
+                return false;
+            });
+        }
+        Update((size_t)-1);
+    }
+}
+
+// Copy every image of the asset into the pixel buffer and let the driver
+// transfer it to the texture. Returns the bytes uploaded.
+size_t AssetLoader::upload(Asset &asset)
+{
+    if (asset.Baked)
+        return uploadBaked(asset);
+
+    // Every image must have decoded, and arrays and cube maps need matching
+    // sizes. Cancelled assets skip straight to freeing their images.
+    const Image &first = asset.Images[0];
+    bool valid = asset.Texture != 0;
+    for (size_t i = 0; valid && i < asset.Images.size(); i++)
+    {
+        const Image &image = asset.Images[i];
+        if (!image.Pixels)
+        {
+            std::cout << "Texture failed to load at path: " << asset.Paths[i] << std::endl;
+            valid = false;
+        }
+        else if (image.Width != first.Width || image.Height != first.Height || image.Channels != first.Channels)
+        {
+            std::cout << "Texture " << asset.Paths[i] << " is " << image.Width << "x" << image.Height
+                      << ", expected " << first.Width << "x" << first.Height << std::endl;
+            valid = false;
+        }
+    }
+
+    size_t imageSize = (size_t)first.Width * first.Height * first.Channels;
+    size_t total = imageSize * asset.Images.size();
+    if (valid)
+    {
+        unsigned char *mapped = MapPixelBuffer(pixelBuffer, total);
+        if (mapped)
+        {
+            for (size_t i = 0; i < asset.Images.size(); i++)
+                memcpy(mapped + i * imageSize, asset.Images[i].Pixels, imageSize);
+            valid = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        }
+        else
+            valid = false;
+
+        if (valid)
+        {
+            // With a pixel buffer bound the data pointers are offsets into it
+            GLenum format = pixelFormat(first.Channels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glBindTexture(asset.Target, asset.Texture);
+            if (asset.Target == GL_TEXTURE_2D_ARRAY)
+                glTexImage3D(asset.Target, 0, GL_RGB8, first.Width, first.Height, (GLsizei)asset.Images.size(), 0,
+                             format, GL_UNSIGNED_BYTE, (void *)0);
+            else if (asset.Target == GL_TEXTURE_CUBE_MAP)
+            {
+                for (size_t i = 0; i < asset.Images.size(); i++)
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum)i, 0, GL_RGB, first.Width, first.Height, 0,
+                                 format, GL_UNSIGNED_BYTE, (void *)(i * imageSize));
+            }
+            else
+                glTexImage2D(asset.Target, 0, format, first.Width, first.Height, 0, format, GL_UNSIGNED_BYTE, (void *)0);
+            if (usesMipmaps(asset.Params.MinFilter))
+                glGenerateMipmap(asset.Target);
+            glBindTexture(asset.Target, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        else
+            std::cout << "Failed to map the pixel buffer for " << asset.Paths[0] << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    for (Image &image : asset.Images)
+    {
+        stbi_image_free(image.Pixels);
+        image.Pixels = nullptr;
+    }
+    return valid ? total : 0;
+}
+
+// Same for baked textures: the compressed levels are copied straight from the
+// mapped files, level by level so the layers of a level are contiguous
+size_t AssetLoader::uploadBaked(Asset &asset)
+{
+    // Update checked that every image mapped a matching file
+    const TextureFileHeader *first = asset.Images[0].Baked.Header();
+    bool valid = asset.Texture != 0 && first != nullptr;
+
+    // Cube maps are sampled without mipmaps, only their first level is needed
+    const uint32_t levelCount = valid && usesMipmaps(asset.Params.MinFilter) ? first->LevelCount : 1;
+    const size_t count = asset.Images.size();
+    size_t total = 0;
+    for (uint32_t level = 0; valid && level < levelCount; level++)
+        total += ((const TextureFileLevel *)(first + 1))[level].Size * count;
+
+    if (valid)
+    {
+        unsigned char *mapped = MapPixelBuffer(pixelBuffer, total);
+        if (mapped)
+        {
+            size_t offset = 0;
+            for (uint32_t level = 0; level < levelCount; level++)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    const BakedImage &baked = asset.Images[i].Baked;
+                    const TextureFileLevel &source = baked.Level(level);
+                    memcpy(mapped + offset, baked.Data() + source.Offset, source.Size);
+                    offset += source.Size;
+                }
+            }
+            valid = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        }
+        else
+            valid = false;
+
+        if (valid)
+        {
+            GLenum format = first->Format == TEXTURE_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            glBindTexture(asset.Target, asset.Texture);
+            size_t offset = 0;
+            GLsizei width = first->Width, height = first->Height;
+            for (uint32_t level = 0; level < levelCount; level++)
+            {
+                GLsizei size = (GLsizei)TextureLevelSize(first->Format, width, height);
+                if (asset.Target == GL_TEXTURE_2D_ARRAY)
+                    glCompressedTexImage3D(asset.Target, level, format, width, height, (GLsizei)count, 0,
+                                           size * (GLsizei)count, (void *)offset);
+                else if (asset.Target == GL_TEXTURE_CUBE_MAP)
+                {
+                    for (size_t i = 0; i < count; i++)
+                        glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum)i, level, format, width, height,
+                                               0, size, (void *)(offset + i * size));
+                }
+                else
+                    glCompressedTexImage2D(asset.Target, level, format, width, height, 0, size, (void *)offset);
+                offset += (size_t)size * count;
+                width = width > 1 ? width / 2 : 1;
+                height = height > 1 ? height / 2 : 1;
+            }
+            glTexParameteri(asset.Target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+            glBindTexture(asset.Target, 0);
+        }
+        else
+            std::cout << "Failed to map the pixel buffer for " << asset.Paths[0] << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // A cancelled asset can still hold images that fell back to decoding
+    for (Image &image : asset.Images)
+    {
+        stbi_image_free(image.Pixels);
+        image.Pixels = nullptr;
+        image.Baked.Close();
+    }
+    return valid ? total : 0;
+}
@@ -0,0 +1,94 @@
+#include "asset_pack.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+static const AssetPack *mountedPack = nullptr;
+
+// Pack names are normalised relative paths with forward slashes, as written by pack_assets
+static std::string packName(const std::string &path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+AssetPack::AssetPack() : header(nullptr), entries(nullptr), names(nullptr) {}
+
+bool AssetPack::Open(const std::string &path)
+{
+    header = nullptr;
+    if (!file.Open(path))
+        return false;
+
+    const AssetPackHeader *h = (const AssetPackHeader *)file.Data();
+    if (file.Size() < sizeof(AssetPackHeader) || memcmp(h->Magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0)
+    {
+        std::cout << "Not an asset pack: " << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    const size_t tableEnd = sizeof(AssetPackHeader) + (size_t)h->EntryCount * sizeof(AssetPackEntry) + h->NamesSize;
+    const AssetPackEntry *e = (const AssetPackEntry *)(h + 1);
+    bool valid = file.Size() >= tableEnd;
+    for (uint32_t i = 0; valid && i < h->EntryCount; i++)
+        valid = (size_t)e[i].NameOffset + e[i].NameLength <= h->NamesSize && e[i].Offset >= tableEnd &&
+                e[i].Offset + e[i].Size <= file.Size();
+    if (!valid)
+    {
+        std::cout << "Corrupt asset pack: " << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    header = h;
+    entries = e;
+    names = (const char *)(e + h->EntryCount);
+    return true;
+}
+
+std::string AssetPack::Name(int entry) const
+{
+    return std::string(names + entries[entry].NameOffset, entries[entry].NameLength);
+}
+
+AssetView AssetPack::Find(const std::string &name) const
+{
+    AssetView view;
+    int lo = 0, hi = Count() - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        const AssetPackEntry &entry = entries[mid];
+        int order = name.compare(0, std::string::npos, names + entry.NameOffset, entry.NameLength);
+        if (order == 0)
+        {
+            view.Data = file.Data() + entry.Offset;
+            view.Size = (size_t)entry.Size;
+            break;
+        }
+        if (order < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+    return view;
+}
+
+void MountAssetPack(const AssetPack *pack)
+{
+    mountedPack = pack;
+}
+
+AssetView FindAsset(const std::string &path)
+{
+    if (!mountedPack)
+        return AssetView();
+    return mountedPack->Find(packName(path));
+}
+
+bool AssetExists(const std::string &path)
+{
+    std::error_code error;
+    return FindAsset(path).Valid() || std::filesystem::exists(path, error);
+}
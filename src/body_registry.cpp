@@ -0,0 +1,179 @@
+#include "body_registry.h"
+
+#include "orbit_kernel.h"
+#include "nbody.h"
+#include "ephemeris.h"
+
+#include <cmath>
+#include <iostream>
+
+int BodyRegistry::Add(const BodyDesc &desc)
+{
+    int parent = -1;
+    if (desc.Parent)
+    {
+        parent = Find(desc.Parent);
+        if (parent < 0)
+        {
+            std::cout << "Unknown parent body " << desc.Parent << " for " << desc.Name << std::endl;
+            return -1;
+        }
+    }
+
+    float inclination = glm::radians(desc.Inclination);
+    float node = glm::radians(desc.AscendingNode);
+    float periapsis = glm::radians(desc.Periapsis);
+    if (desc.Eccentricity != 0.0f || desc.Inclination != 0.0f)
+    {
+        kepler.Add(desc.OrbitRadius, desc.Eccentricity, inclination, node, periapsis, 0.0f, desc.OrbitRate);
+        keplerBody.push_back(Count());
+        keplerX.push_back(0.0f);
+        keplerY.push_back(0.0f);
+        keplerZ.push_back(0.0f);
+    }
+
+    // The line loop has x = r sin E and z = r cos E, which is exactly the
+    // parametrisation of the ellipse in eccentric anomaly
+    float P[3], Q[3];
+    KeplerBasis(desc.OrbitRadius, desc.Eccentricity, inclination, node, periapsis, P, Q);
+    glm::mat4 orbit(1.0f);
+    orbit[0] = glm::vec4(Q[0], Q[1], Q[2], 0.0f) / ORBIT_MESH_RADIUS;
+    orbit[2] = glm::vec4(P[0], P[1], P[2], 0.0f) / ORBIT_MESH_RADIUS;
+    orbit[3] = glm::vec4(-desc.Eccentricity * P[0], -desc.Eccentricity * P[1], -desc.Eccentricity * P[2], 1.0f);
+
+    Name.push_back(desc.Name);
+    OrbitRadius.push_back(desc.OrbitRadius);
+    OrbitRate.push_back(desc.OrbitRate);
+    Eccentricity.push_back(desc.Eccentricity);
+    Inclination.push_back(desc.Inclination);
+    AscendingNode.push_back(desc.AscendingNode);
+    Periapsis.push_back(desc.Periapsis);
+    AxialTilt.push_back(desc.AxialTilt);
+    SpinRate.push_back(desc.SpinRate);
+    Mass.push_back(desc.Mass);
+    Radius.push_back(desc.Radius);
+    Parent.push_back(parent);
+    TiltCos.push_back(cosf(glm::radians(desc.AxialTilt)));
+    TiltSin.push_back(sinf(glm::radians(desc.AxialTilt)));
+    Scale.push_back(desc.Radius);
+    Orbit.push_back(orbit);
+    TextureLayer.push_back(0.0f);
+    Position.push_back(glm::vec3(0.0f));
+    Model.push_back(glm::mat4(1.0f));
+    ephemerisBody.push_back(-1);
+    if (ephemeris)
+        SetEphemeris(ephemeris);
+
+    return Count() - 1;
+}
+
+int BodyRegistry::Find(const std::string &name) const
+{
+    for (int i = 0; i < Count(); i++)
+    {
+        if (Name[i] == name)
+            return i;
+    }
+    return -1;
+}
+
+void BodyRegistry::Update(double orbitTime, double spinTime)
+{
+    const int n = Count();
+    if (n == 0)
+        return;
+
+    OrbitBatch batch = {n, OrbitRadius.data(), OrbitRate.data(), SpinRate.data(),
+                        TiltCos.data(), TiltSin.data(), Scale.data()};
+    EvaluateOrbits(batch, orbitTime, spinTime, &Model[0][0][0]);
+
+    // Replace the circular position for bodies on Keplerian orbits
+    const bool useEphemeris = ephemeris && ephemeris->Covers(orbitTime);
+    const int k = kepler.Count();
+    if (k > 0 && !(useEphemeris && ephemerisCoversKepler))
+    {
+        PropagateKepler(kepler, orbitTime, 0, k, keplerX.data(), keplerY.data(), keplerZ.data());
+        for (int j = 0; j < k; j++)
+            Model[keplerBody[j]][3] = glm::vec4(keplerX[j], keplerY[j], keplerZ[j], 1.0f);
+    }
+
+    if (useEphemeris)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (ephemerisBody[i] < 0)
+                continue;
+            double x, y, z;
+            ephemeris->Evaluate(ephemerisBody[i], orbitTime, x, y, z);
+            Model[i][3] = glm::vec4((float)x, (float)y, (float)z, 1.0f);
+        }
+    }
+
+    // Satellites are offset by their parent, which always comes first
+    for (int i = 0; i < n; i++)
+    {
+        if (Parent[i] >= 0)
+            Model[i][3] += glm::vec4(Position[Parent[i]], 0.0f);
+        Position[i] = glm::vec3(Model[i][3]);
+    }
+}
+
+void BodyRegistry::SetEphemeris(const Ephemeris *source)
+{
+    ephemeris = source;
+    ephemerisCoversKepler = ephemeris != nullptr;
+    for (int i = 0; i < Count(); i++)
+        ephemerisBody[i] = ephemeris ? ephemeris->Find(Name[i]) : -1;
+    for (int body : keplerBody)
+    {
+        if (ephemerisBody[body] < 0)
+            ephemerisCoversKepler = false;
+    }
+}
+
+void BodyRegistry::Seed(NBodySystem &system, double orbitTime) const
+{
+    const int n = Count();
+
+    // Bodies without a parent orbit whatever sits at the origin
+    double originMass = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        if (Parent[i] < 0 && OrbitRadius[i] <= 0.0f)
+            originMass += Mass[i];
+    }
+
+    std::vector<glm::vec3> velocity(n, glm::vec3(0.0f));
+    for (int i = 0; i < n; i++)
+    {
+        float a = OrbitRadius[i];
+        if (a > 0.0f)
+        {
+            // Keep the phase on the ellipse, but move at the speed gravity dictates
+            double central = Parent[i] >= 0 ? Mass[Parent[i]] : originMass;
+            float meanMotion = (float)sqrt(system.G * central / ((double)a * a * a));
+            float e = Eccentricity[i];
+            float E = SolveKepler(simd::ReducePhase(orbitTime * OrbitRate[i]), e);
+            glm::vec3 P = glm::vec3(Orbit[i][2]) * ORBIT_MESH_RADIUS;
+            glm::vec3 Q = glm::vec3(Orbit[i][0]) * ORBIT_MESH_RADIUS;
+            velocity[i] = (Q * cosf(E) - P * sinf(E)) * (meanMotion / (1.0f - e * cosf(E)));
+        }
+        if (Parent[i] >= 0)
+            velocity[i] += velocity[Parent[i]];
+
+        system.Add(Position[i].x, Position[i].y, Position[i].z,
+                   velocity[i].x, velocity[i].y, velocity[i].z, Mass[i]);
+    }
+}
+
+void BodyRegistry::SetPositions(const NBodySystem &system, double alpha)
+{
+    const int n = Count() < system.Count() ? Count() : system.Count();
+    for (int i = 0; i < n; i++)
+    {
+        double x, y, z;
+        system.Interpolate(i, alpha, x, y, z);
+        Position[i] = glm::vec3((float)x, (float)y, (float)z);
+        Model[i][3] = glm::vec4(Position[i], 1.0f);
+    }
+}
@@ -0,0 +1,48 @@
+#include "cubemap_cache.h"
+
+#include <iostream>
+
+CubemapCache::CubemapCache(TextureManager &textures, AssetLoader &loader, double unloadSeconds)
+    : textures(textures), loader(loader), unloadSeconds(unloadSeconds)
+{
+}
+
+int CubemapCache::Add(const std::vector<std::string> &faces)
+{
+    Environment environment;
+    environment.Faces = faces;
+    environments.push_back(environment);
+    return (int)environments.size() - 1;
+}
+
+bool CubemapCache::Loaded(int environment) const
+{
+    const TextureRef &texture = environments[environment].Texture;
+    return texture && loader.Loaded(texture->ID);
+}
+
+GLuint CubemapCache::Get(int environment, int fallback, double now)
+{
+    Environment &wanted = environments[environment];
+    wanted.LastUsed = now;
+    if (!wanted.Texture)
+        wanted.Texture = textures.Cubemap(wanted.Faces);
+    if (Loaded(environment) || fallback == environment || !Loaded(fallback))
+        return wanted.Texture->ID;
+
+    // Keep the fallback alive while it stands in
+    environments[fallback].LastUsed = now;
+    return environments[fallback].Texture->ID;
+}
+
+void CubemapCache::Update(double now)
+{
+    for (Environment &environment : environments)
+    {
+        if (environment.Texture && now - environment.LastUsed > unloadSeconds)
+        {
+            std::cout << "Unloaded skybox " << environment.Faces[0] << std::endl;
+            environment.Texture.reset();
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#include "ephemeris.h"
+#include "asset_pack.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+const double PI = 3.14159265358979323846;
+} // namespace
+
+double ChebyshevNode(int j, int n)
+{
+    return cos(PI * (j + 0.5) / n);
+}
+
+void FitChebyshev(const double *samples, int n, double *coefficients)
+{
+    // Discrete orthogonality of T_k over the Chebyshev nodes
+    for (int k = 0; k < n; k++)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++)
+            sum += samples[j] * cos(PI * k * (j + 0.5) / n);
+        coefficients[k] = (k == 0 ? 1.0 : 2.0) * sum / n;
+    }
+}
+
+Ephemeris::Ephemeris() : header(nullptr), bodies(nullptr), coefficients(nullptr) {}
+
+bool Ephemeris::Load(const std::string &path)
+{
+    header = nullptr;
+    file.Close();
+
+    // Packed files are page aligned, so the doubles can be read in place
+    AssetView data = FindAsset(path);
+    if (!data.Valid())
+    {
+        if (!file.Open(path))
+            return false;
+        data.Data = file.Data();
+        data.Size = file.Size();
+    }
+
+    const EphemerisHeader *h = (const EphemerisHeader *)data.Data;
+    if (data.Size < sizeof(EphemerisHeader) || memcmp(h->Magic, EPHEMERIS_MAGIC, sizeof(EPHEMERIS_MAGIC)) != 0)
+    {
+        std::cout << "Not an ephemeris file: " << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    size_t expected = sizeof(EphemerisHeader) + h->BodyCount * sizeof(EphemerisBody) +
+                      (size_t)h->RecordCount * h->RecordSize * sizeof(double);
+    const EphemerisBody *b = (const EphemerisBody *)(h + 1);
+    bool valid = data.Size == expected && h->RecordCount > 0 && h->RecordLength > 0.0;
+    for (uint32_t i = 0; valid && i < h->BodyCount; i++)
+        valid = b[i].Order > 0 && b[i].SubIntervals > 0 &&
+                (uint64_t)b[i].Offset + 3ull * b[i].Order * b[i].SubIntervals <= h->RecordSize;
+    if (!valid)
+    {
+        std::cout << "Corrupt ephemeris file: " << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    header = h;
+    bodies = b;
+    coefficients = (const double *)(b + h->BodyCount);
+    return true;
+}
+
+std::string Ephemeris::Name(int body) const
+{
+    const char *name = bodies[body].Name;
+    return std::string(name, strnlen(name, sizeof(bodies[body].Name)));
+}
+
+int Ephemeris::Find(const std::string &name) const
+{
+    for (int i = 0; i < Count(); i++)
+    {
+        if (Name(i) == name)
+            return i;
+    }
+    return -1;
+}
+
+void Ephemeris::Evaluate(int body, double time, double &x, double &y, double &z) const
+{
+    const EphemerisBody &b = bodies[body];
+
+    // Locate the record, then the sub-interval, clamping the very end of the span
+    double t = (time - header->StartTime) / header->RecordLength;
+    int record = (int)floor(t);
+    if (record >= (int)header->RecordCount)
+        record = header->RecordCount - 1;
+    if (record < 0)
+        record = 0;
+    double s = (t - record) * b.SubIntervals;
+    int sub = (int)floor(s);
+    if (sub >= (int)b.SubIntervals)
+        sub = b.SubIntervals - 1;
+    if (sub < 0)
+        sub = 0;
+    double u = 2.0 * (s - sub) - 1.0;
+
+    const int n = b.Order;
+    const double *c = coefficients + (size_t)record * header->RecordSize + b.Offset + (size_t)sub * 3 * n;
+    x = Clenshaw(c, n, u);
+    y = Clenshaw(c + n, n, u);
+    z = Clenshaw(c + 2 * n, n, u);
+}
@@ -0,0 +1,62 @@
+#include "frame_constants.h"
+
+#include <cstring>
+
+FrameUniformBuffer::FrameUniformBuffer() : slice(0)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = ((GLsizeiptr)sizeof(FrameConstants) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, stride * FRAME_RING_SIZE, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    for (int i = 0; i < FRAME_RING_SIZE; i++)
+        fences[i] = nullptr;
+}
+
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+    for (int i = 0; i < FRAME_RING_SIZE; i++)
+    {
+        if (fences[i])
+            glDeleteSync(fences[i]);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void FrameUniformBuffer::Update(const FrameConstants &constants)
+{
+    slice = (slice + 1) % FRAME_RING_SIZE;
+
+    // Normally long signalled, only blocks if the GPU is FRAME_RING_SIZE frames behind
+    if (fences[slice])
+    {
+        glClientWaitSync(fences[slice], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fences[slice]);
+        fences[slice] = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    void *data = glMapBufferRange(GL_UNIFORM_BUFFER, stride * slice, sizeof(FrameConstants),
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (data)
+    {
+        memcpy(data, &constants, sizeof(FrameConstants));
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    else
+        glBufferSubData(GL_UNIFORM_BUFFER, stride * slice, sizeof(FrameConstants), &constants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, buffer, stride * slice, sizeof(FrameConstants));
+}
+
+void FrameUniformBuffer::EndFrame()
+{
+    if (fences[slice])
+        glDeleteSync(fences[slice]);
+    fences[slice] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,149 @@
+#include "frustum.h"
+
+#include <cmath>
+#include <cstddef>
+
+void Frustum::Extract(const glm::mat4 &m)
+{
+    // Rows of the matrix, glm stores columns
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++)
+        row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    Planes[0] = row[3] + row[0];
+    Planes[1] = row[3] - row[0];
+    Planes[2] = row[3] + row[1];
+    Planes[3] = row[3] - row[1];
+    Planes[4] = row[3] + row[2];
+    Planes[5] = row[3] - row[2];
+    for (glm::vec4 &plane : Planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::SphereVisible(const glm::vec3 &center, float radius) const
+{
+    for (const glm::vec4 &plane : Planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+void BoundingSpheres::Clear()
+{
+    X.clear();
+    Y.clear();
+    Z.clear();
+    Radius.clear();
+}
+
+int BoundingSpheres::Add(const glm::vec3 &center, float radius)
+{
+    X.push_back(center.x);
+    Y.push_back(center.y);
+    Z.push_back(center.z);
+    Radius.push_back(radius);
+    return Count() - 1;
+}
+
+namespace
+{
+void CullScalar(const Frustum &f, const BoundingSpheres &s, unsigned char *visible, int first)
+{
+    for (int i = first; i < s.Count(); i++)
+        visible[i] = f.SphereVisible(glm::vec3(s.X[i], s.Y[i], s.Z[i]), s.Radius[i]) ? 1 : 0;
+}
+
+#if SIMD_X86
+// Lanes hold four spheres, each plane is broadcast and tested against all of them
+SIMD_TARGET_SSE2 void CullSSE2(const Frustum &f, const BoundingSpheres &s, unsigned char *visible)
+{
+    int i = 0;
+    for (; i + 4 <= s.Count(); i += 4)
+    {
+        __m128 x = _mm_loadu_ps(s.X.data() + i);
+        __m128 y = _mm_loadu_ps(s.Y.data() + i);
+        __m128 z = _mm_loadu_ps(s.Z.data() + i);
+        __m128 r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(s.Radius.data() + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4 &plane : f.Planes)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y));
+            d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), z)), _mm_set1_ps(plane.w));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, r));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++)
+            visible[i + lane] = (unsigned char)((mask >> lane) & 1);
+    }
+    CullScalar(f, s, visible, i);
+}
+
+SIMD_TARGET_AVX2 void CullAVX2(const Frustum &f, const BoundingSpheres &s, unsigned char *visible)
+{
+    int i = 0;
+    for (; i + 8 <= s.Count(); i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(s.X.data() + i);
+        __m256 y = _mm256_loadu_ps(s.Y.data() + i);
+        __m256 z = _mm256_loadu_ps(s.Z.data() + i);
+        __m256 r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(s.Radius.data() + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const glm::vec4 &plane : f.Planes)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x), _mm256_mul_ps(_mm256_set1_ps(plane.y), y));
+            d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.z), z)), _mm256_set1_ps(plane.w));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, r, _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; lane++)
+            visible[i + lane] = (unsigned char)((mask >> lane) & 1);
+    }
+    CullScalar(f, s, visible, i);
+}
+#endif
+} // namespace
+
+SimdLevel FrustumCullLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+void CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, unsigned char *visible)
+{
+    CullSpheres(frustum, spheres, visible, FrustumCullLevel());
+}
+
+void CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, unsigned char *visible, SimdLevel level)
+{
+    if (level > FrustumCullLevel())
+        level = FrustumCullLevel();
+
+    switch (level)
+    {
+#if SIMD_X86
+    case SIMD_AVX2:
+        CullAVX2(frustum, spheres, visible);
+        break;
+    case SIMD_SSE2:
+        CullSSE2(frustum, spheres, visible);
+        break;
+#endif
+    default:
+        CullScalar(frustum, spheres, visible, 0);
+        break;
+    }
+}
+
+float ScreenRadius(const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight,
+                   const glm::vec3 &center, float radius)
+{
+    glm::vec4 eye = view * glm::vec4(center, 1.0f);
+    float distance = -eye.z;
+    // Inside or just in front of the sphere it covers the whole screen
+    if (distance <= radius)
+        return viewportHeight;
+    return radius * projection[1][1] * 0.5f * viewportHeight / distance;
+}
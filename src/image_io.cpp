@@ -0,0 +1,102 @@
+#include "image_io.h"
+
+#include "asset_pack.h"
+
+#include <stb_image.h>
+
+#include <cstring>
+#include <iostream>
+
+bool ReadImageSize(const std::string &path, int &width, int &height)
+{
+    int channels;
+    AssetView data = FindAsset(path);
+    if (data.Valid())
+        return stbi_info_from_memory(data.Data, (int)data.Size, &width, &height, &channels) != 0;
+    return stbi_info(path.c_str(), &width, &height, &channels) != 0;
+}
+
+unsigned char *DecodeImage(const std::string &path, int &width, int &height, int &channels, int components)
+{
+    // Packed images decode straight from the mapping
+    AssetView data = FindAsset(path);
+    if (data.Valid())
+        return stbi_load_from_memory(data.Data, (int)data.Size, &width, &height, &channels, components);
+    return stbi_load(path.c_str(), &width, &height, &channels, components);
+}
+
+bool DecodeImageRGB(const std::string &path, std::vector<unsigned char> &pixels, int &width, int &height)
+{
+    int channels;
+    unsigned char *data = DecodeImage(path, width, height, channels, 3);
+    if (!data)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return false;
+    }
+    pixels.assign(data, data + (size_t)width * height * 3);
+    stbi_image_free(data);
+    return true;
+}
+
+bool CompressedTexturesSupported()
+{
+    static const bool supported = []() {
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; i++)
+        {
+            const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+            if (name && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+                return true;
+        }
+        return false;
+    }();
+    return supported;
+}
+
+bool BakedImage::Open(const std::string &source)
+{
+    Close();
+    const std::string path = BakedTexturePath(source);
+    AssetView view = FindAsset(path);
+    if (!view.Valid())
+    {
+        file.reset(new MappedFile());
+        if (file->Open(path))
+        {
+            view.Data = file->Data();
+            view.Size = file->Size();
+        }
+    }
+    if (!view.Valid() || !ValidateTextureFile(view.Data, view.Size, path))
+    {
+        file.reset();
+        return false;
+    }
+    data = view.Data;
+    return true;
+}
+
+void BakedImage::Close()
+{
+    data = nullptr;
+    file.reset();
+}
+
+unsigned char *MapPixelBuffer(GLuint buffer, size_t size)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+    return (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+bool StagePixels(GLuint buffer, const void *data, size_t size)
+{
+    unsigned char *mapped = MapPixelBuffer(buffer, size);
+    if (!mapped)
+        return false;
+    memcpy(mapped, data, size);
+    return glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+}
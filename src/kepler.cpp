@@ -0,0 +1,222 @@
+#include "kepler.h"
+
+#include <cmath>
+#include <cstddef>
+
+void KeplerBasis(float a, float e, float inclination, float ascendingNode, float periapsis,
+                 float P[3], float Q[3])
+{
+    double cO = cos(ascendingNode), sO = sin(ascendingNode);
+    double cw = cos(periapsis), sw = sin(periapsis);
+    double ci = cos(inclination), si = sin(inclination);
+    double b = a * sqrt(1.0 - (double)e * e);
+
+    // Ecliptic frame with Z towards the north pole
+    double px = cO * cw - sO * sw * ci;
+    double py = sO * cw + cO * sw * ci;
+    double pz = sw * si;
+    double qx = -cO * sw - sO * cw * ci;
+    double qy = -sO * sw + cO * cw * ci;
+    double qz = cw * si;
+
+    // Scene axes: ecliptic Y -> x, north -> y, ecliptic X -> z, matching the circular orbits
+    P[0] = (float)(a * py);
+    P[1] = (float)(a * pz);
+    P[2] = (float)(a * px);
+    Q[0] = (float)(b * qy);
+    Q[1] = (float)(b * qz);
+    Q[2] = (float)(b * qx);
+}
+
+float SolveKepler(float M, float e)
+{
+    float s, c;
+    simd::SinCos(M, s, c);
+    float E = M + e * s;
+
+    // Halley's method on f(E) = E - e sin E - M
+    for (int k = 0; k < KEPLER_ITERATIONS; k++)
+    {
+        simd::SinCos(E, s, c);
+        float es = e * s;
+        float f = E - es - M;
+        float fp = 1.0f - e * c;
+        E = E - f / (fp - 0.5f * f * es / fp);
+    }
+    return E;
+}
+
+int KeplerOrbits::Add(float a, float e, float inclination, float ascendingNode, float periapsis,
+                      float meanAnomaly, float meanMotion)
+{
+    float P[3], Q[3];
+    KeplerBasis(a, e, inclination, ascendingNode, periapsis, P, Q);
+
+    SemiMajorAxis.push_back(a);
+    Eccentricity.push_back(e);
+    Inclination.push_back(inclination);
+    AscendingNode.push_back(ascendingNode);
+    Periapsis.push_back(periapsis);
+    MeanAnomaly.push_back(simd::ReducePhase(meanAnomaly));
+    MeanMotion.push_back(meanMotion);
+    Px.push_back(P[0]);
+    Py.push_back(P[1]);
+    Pz.push_back(P[2]);
+    Qx.push_back(Q[0]);
+    Qy.push_back(Q[1]);
+    Qz.push_back(Q[2]);
+    return Count() - 1;
+}
+
+void KeplerOrbits::Clear()
+{
+    for (std::vector<float> *v : {&SemiMajorAxis, &Eccentricity, &Inclination, &AscendingNode, &Periapsis,
+                                  &MeanAnomaly, &MeanMotion, &Px, &Py, &Pz, &Qx, &Qy, &Qz})
+        v->clear();
+}
+
+namespace
+{
+const float PI = (float)(simd::TWO_PI / 2.0);
+const float TWO_PI = (float)simd::TWO_PI;
+
+// The reduced phase plus the mean anomaly at time 0 lies in [-2pi, 2pi],
+// one step back brings it into the [-pi, pi] SolveKepler expects
+inline float WrapAnomaly(float M)
+{
+    if (M > PI)
+        return M - TWO_PI;
+    if (M < -PI)
+        return M + TWO_PI;
+    return M;
+}
+
+void PropagateScalar(const KeplerOrbits &o, double time, int first, int end, float *x, float *y, float *z)
+{
+    for (int i = first; i < end; i++)
+    {
+        float e = o.Eccentricity[i];
+        float M = WrapAnomaly(simd::ReducePhase(time * o.MeanMotion[i]) + o.MeanAnomaly[i]);
+        float E = SolveKepler(M, e);
+        float s, c;
+        simd::SinCos(E, s, c);
+        float u = c - e;
+        x[i] = o.Px[i] * u + o.Qx[i] * s;
+        y[i] = o.Py[i] * u + o.Qy[i] * s;
+        z[i] = o.Pz[i] * u + o.Qz[i] * s;
+    }
+}
+
+#if SIMD_X86
+SIMD_TARGET_SSE2 inline __m128 WrapAnomaly4(__m128 M)
+{
+    const __m128 pi = _mm_set1_ps(PI), twoPi = _mm_set1_ps(TWO_PI);
+    M = _mm_sub_ps(M, _mm_and_ps(_mm_cmpgt_ps(M, pi), twoPi));
+    return _mm_add_ps(M, _mm_and_ps(_mm_cmplt_ps(M, _mm_sub_ps(_mm_setzero_ps(), pi)), twoPi));
+}
+
+SIMD_TARGET_AVX2 inline __m256 WrapAnomaly8(__m256 M)
+{
+    const __m256 pi = _mm256_set1_ps(PI), twoPi = _mm256_set1_ps(TWO_PI);
+    M = _mm256_sub_ps(M, _mm256_and_ps(_mm256_cmp_ps(M, pi, _CMP_GT_OQ), twoPi));
+    return _mm256_add_ps(M, _mm256_and_ps(_mm256_cmp_ps(M, _mm256_set1_ps(-PI), _CMP_LT_OQ), twoPi));
+}
+
+SIMD_TARGET_SSE2 void PropagateSSE2(const KeplerOrbits &o, double time, int first, int end, float *x, float *y, float *z)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    int i = first;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 e = _mm_loadu_ps(&o.Eccentricity[i]);
+        __m128 M = WrapAnomaly4(_mm_add_ps(simd::Phase4(&o.MeanMotion[i], time), _mm_loadu_ps(&o.MeanAnomaly[i])));
+        __m128 s, c;
+        simd::SinCos4(M, s, c);
+        __m128 E = _mm_add_ps(M, _mm_mul_ps(e, s));
+
+        for (int k = 0; k < KEPLER_ITERATIONS; k++)
+        {
+            simd::SinCos4(E, s, c);
+            __m128 es = _mm_mul_ps(e, s);
+            __m128 f = _mm_sub_ps(_mm_sub_ps(E, es), M);
+            __m128 fp = _mm_sub_ps(one, _mm_mul_ps(e, c));
+            __m128 d = _mm_sub_ps(fp, _mm_div_ps(_mm_mul_ps(_mm_mul_ps(half, f), es), fp));
+            E = _mm_sub_ps(E, _mm_div_ps(f, d));
+        }
+
+        simd::SinCos4(E, s, c);
+        __m128 u = _mm_sub_ps(c, e);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&o.Px[i]), u), _mm_mul_ps(_mm_loadu_ps(&o.Qx[i]), s)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&o.Py[i]), u), _mm_mul_ps(_mm_loadu_ps(&o.Qy[i]), s)));
+        _mm_storeu_ps(z + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&o.Pz[i]), u), _mm_mul_ps(_mm_loadu_ps(&o.Qz[i]), s)));
+    }
+    PropagateScalar(o, time, i, end, x, y, z);
+}
+
+SIMD_TARGET_AVX2 void PropagateAVX2(const KeplerOrbits &o, double time, int first, int end, float *x, float *y, float *z)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    int i = first;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 e = _mm256_loadu_ps(&o.Eccentricity[i]);
+        __m256 M = WrapAnomaly8(_mm256_add_ps(simd::Phase8(&o.MeanMotion[i], time), _mm256_loadu_ps(&o.MeanAnomaly[i])));
+        __m256 s, c;
+        simd::SinCos8(M, s, c);
+        __m256 E = _mm256_add_ps(M, _mm256_mul_ps(e, s));
+
+        for (int k = 0; k < KEPLER_ITERATIONS; k++)
+        {
+            simd::SinCos8(E, s, c);
+            __m256 es = _mm256_mul_ps(e, s);
+            __m256 f = _mm256_sub_ps(_mm256_sub_ps(E, es), M);
+            __m256 fp = _mm256_sub_ps(one, _mm256_mul_ps(e, c));
+            __m256 d = _mm256_sub_ps(fp, _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(half, f), es), fp));
+            E = _mm256_sub_ps(E, _mm256_div_ps(f, d));
+        }
+
+        simd::SinCos8(E, s, c);
+        __m256 u = _mm256_sub_ps(c, e);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&o.Px[i]), u), _mm256_mul_ps(_mm256_loadu_ps(&o.Qx[i]), s)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&o.Py[i]), u), _mm256_mul_ps(_mm256_loadu_ps(&o.Qy[i]), s)));
+        _mm256_storeu_ps(z + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&o.Pz[i]), u), _mm256_mul_ps(_mm256_loadu_ps(&o.Qz[i]), s)));
+    }
+    PropagateScalar(o, time, i, end, x, y, z);
+}
+#endif
+} // namespace
+
+void PropagateKepler(const KeplerOrbits &orbits, double time, int first, int count,
+                     float *x, float *y, float *z)
+{
+    static const SimdLevel level = DetectSimdLevel();
+    PropagateKepler(orbits, time, first, count, x, y, z, level);
+}
+
+void PropagateKepler(const KeplerOrbits &orbits, double time, int first, int count,
+                     float *x, float *y, float *z, SimdLevel level)
+{
+    static const SimdLevel supported = DetectSimdLevel();
+    if (level > supported)
+        level = supported;
+
+    int end = first + count;
+    switch (level)
+    {
+#if SIMD_X86
+    case SIMD_AVX2:
+        PropagateAVX2(orbits, time, first, end, x, y, z);
+        break;
+    case SIMD_SSE2:
+        PropagateSSE2(orbits, time, first, end, x, y, z);
+        break;
+#endif
+    default:
+        PropagateScalar(orbits, time, first, end, x, y, z);
+        break;
+    }
+}
@@ -5,30 +5,51 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <stb_image.h>
-
 #include "shader.h"
+#include "program_cache.h"
+#include "shader_reloader.h"
 #include "sphere.h"
+#include "sphere_lod.h"
 #include "camera.h"
-
+#include "body_registry.h"
+#include "solar_system.h"
+#include "ephemeris.h"
+#include "orbit_kernel.h"
+#include "nbody.h"
+#include "thread_pool.h"
+#include "asset_loader.h"
+#include "asset_pack.h"
+#include "texture_manager.h"
+#include "texture_residency.h"
+#include "cubemap_cache.h"
+#include "mip_streamer.h"
+#include "frustum.h"
+#include "occlusion_culler.h"
+#include "sim_clock.h"
+#include "frame_constants.h"
+#include "text_renderer.h"
+
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
-#include <map>
+#include <cstring>
 #include <ctime>
 #include <filesystem>
+#include <random>
 #include <string>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 #define TAU (M_PI * 2.0)
 
+// Size of the planet surface images, larger art is streamed
+const int PLANET_TEXTURE_WIDTH = 2048, PLANET_TEXTURE_HEIGHT = 1024;
+
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void processInput(GLFWwindow *window);
-void RenderText(Shader &s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
-unsigned int loadTexture(char const *path);
-unsigned int loadCubemap(std::vector<std::string> faces);
-void ShowInfo(Shader &s);
+void ShowInfo(TextRenderer &hud, const int labels[4]);
+void AddAsteroidBelt(NBodySystem &sim, int count);
 
 void GetDesktopResolution(float &horizontal, float &vertical)
 {
@@ -37,11 +58,13 @@ void GetDesktopResolution(float &horizontal, float &vertical)
 }
 
 GLfloat deltaTime = 0.0f;
-GLfloat lastFrame = 0.0f;
+double lastFrame = 0.0;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 bool onRotate = false;
 bool onFreeCam = true;
 bool SkyBoxExtra = false;
+bool NBodyMode = false;
+bool NBodyToggle = false;
 float SCREEN_WIDTH = 800, SCREEN_HEIGHT = 600;
 
 glm::vec3 point = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -66,6 +89,9 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
         onPlanet = true;
     }
 
+    if (key == GLFW_KEY_N && action == GLFW_PRESS)
+        NBodyToggle = true;
+
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -78,16 +104,6 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 bool firstMouse = true;
 GLfloat xoff = 0.0f, yoff = 0.0f;
 
-struct Character
-{
-    GLuint TextureID;   // ID handle of the glyph texture
-    glm::ivec2 Size;    // Size of glyph
-    glm::ivec2 Bearing; // Offset from baseline to left/top of glyph
-    GLuint Advance;     // Horizontal offset to advance to next glyph
-};
-std::map<GLchar, Character> Characters;
-GLuint textVAO, textVBO;
-
 struct PlanetInfo
 {
     std::string Name;
@@ -175,6 +191,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // Shaders link from cached binaries when the driver supports it
+    InitProgramCache((GLADloadproc)glfwGetProcAddress);
     /* LOAD GLAD */
 
     glEnable(GL_DEPTH_TEST);
@@ -183,17 +201,48 @@ int main()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_CULL_FACE);
 
+    /* ASSET PACK */
+    // Built by the asset_pack target; loose files under resources/ and shaders/
+    // are used for anything the pack does not contain
+    AssetPack assetPack;
+    if (std::filesystem::exists("assets.pack") && assetPack.Open("assets.pack"))
+    {
+        MountAssetPack(&assetPack);
+        std::cout << "Asset pack: " << assetPack.Count() << " files" << std::endl;
+    }
+    /* ASSET PACK */
+
     /* SHADERS */
-    Shader SimpleShader("shaders/simpleVS.vs", "shaders/simpleFS.fs");
+    Shader SimpleShader("shaders/surface.vs", "shaders/surface.fs");
     Shader SkyboxShader("shaders/skybox.vs", "shaders/skybox.fs");
-    Shader texShader("shaders/simpleVS.vs", "shaders/texFS.fs");
     Shader TextShader("shaders/TextShader.vs", "shaders/TextShader.fs");
-    /* SHADERS */
+    Shader PointShader("shaders/points.vs", "shaders/points.fs");
+    Shader PlanetShader("shaders/surface.vs", "shaders/surface.fs", nullptr, "INSTANCED");
+
+    // Camera and projection come from one uniform buffer shared by all programs
+    FrameUniformBuffer frameUniforms;
+
+    // Block bindings, sampler units and the handles of uniforms set every
+    // frame; done again whenever an edited shader is swapped in
+    UniformHandle simpleModel, simpleColor, pointColor;
+    auto configureShaders = [&]() {
+        for (const Shader *shader : {&SimpleShader, &SkyboxShader, &TextShader, &PointShader, &PlanetShader})
+            shader->BindBlock("FrameConstants", FRAME_CONSTANTS_BINDING);
+        simpleModel = SimpleShader.Uniform("model");
+        simpleColor = SimpleShader.Uniform("flatColor");
+        pointColor = PointShader.Uniform("color");
+        PlanetShader.Use();
+        PlanetShader.setInt("planetTextures", 0);
+        PlanetShader.setInt("detailTextures", 1);
+        PlanetShader.setInt("streamedTexture", 2);
+    };
+    configureShaders();
 
-    // PROJECTION FOR TEXT RENDER
-    glm::mat4 Text_projection = glm::ortho(0.0f, SCREEN_WIDTH, 0.0f, SCREEN_HEIGHT);
-    TextShader.Use();
-    glUniformMatrix4fv(glGetUniformLocation(TextShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(Text_projection));
+    // Edits under shaders/ recompile in the background and swap in once linked
+    ShaderReloader shaderReloader(window);
+    for (Shader *shader : {&SimpleShader, &SkyboxShader, &TextShader, &PointShader, &PlanetShader})
+        shaderReloader.Watch(*shader);
+    /* SHADERS */
 
     float cube[] = {
         -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
@@ -300,8 +349,8 @@ int main()
     for (int i = 0; i < 2000; i++)
     {
         angl = (float)(M_PI / 2 - i * (M_PI / 1000));
-        xx = sin(angl) * 100.0f;
-        zz = cos(angl) * 100.0f;
+        xx = sin(angl) * ORBIT_MESH_RADIUS;
+        zz = cos(angl) * ORBIT_MESH_RADIUS;
         orbVert.push_back(xx);
         orbVert.push_back(0.0f);
         orbVert.push_back(zz);
@@ -321,55 +370,182 @@ int main()
     glBindVertexArray(0);
     /* VAO-VBO for ORBITS*/
 
-    /* TEXT RENDERING VAO-VBO*/
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    /* VAO-VBO for N-BODY PARTICLES */
+    GLuint beltVAO, beltVBO;
+    std::vector<float> beltVert;
+    glGenVertexArrays(1, &beltVAO);
+    glGenBuffers(1, &beltVBO);
+    glBindVertexArray(beltVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, beltVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-    /* TEXT RENDERING VAO-VBO*/
+    /* VAO-VBO for N-BODY PARTICLES */
+
+    /* TEXT RENDERING */
+    TextRenderer hud;
+    const glm::vec3 hudColor(0.7f, 0.7f, 0.11f);
+    const int overviewLabels[] = {
+        hud.CreateLabel("SOLAR SYSTEM ", TEXT_TOP_LEFT, 25.0f, 30.0f, 0.50f, hudColor),
+        hud.CreateLabel("STARS: 1 (SUN) ", TEXT_TOP_LEFT, 25.0f, 55.0f, 0.35f, hudColor),
+        hud.CreateLabel("PLANETS: 8 (MAYBE 9) ", TEXT_TOP_LEFT, 25.0f, 80.0f, 0.35f, hudColor),
+        hud.CreateLabel("SATELLITES: 415 ", TEXT_TOP_LEFT, 25.0f, 105.0f, 0.35f, hudColor),
+        hud.CreateLabel("COMMETS: 3441 ", TEXT_TOP_LEFT, 25.0f, 130.0f, 0.35f, hudColor),
+    };
+    const int freeCamLabel = hud.CreateLabel("FREE CAM ", TEXT_TOP_RIGHT, 200.0f, 30.0f, 0.35f, hudColor);
+    const int staticCamLabel = hud.CreateLabel("STATIC CAM ", TEXT_TOP_RIGHT, 200.0f, 30.0f, 0.35f, hudColor);
+    const int planetCamLabel = hud.CreateLabel("PLANET CAM ", TEXT_TOP_RIGHT, 200.0f, 30.0f, 0.35f, hudColor);
+    int infoLabels[4];
+    for (int i = 0; i < 4; i++)
+        infoLabels[i] = hud.CreateLabel("", TEXT_TOP_LEFT, 25.0f, 30.0f + 20.0f * i, 0.35f, hudColor);
+    int infoPlanet = 0; // planet the info labels were last filled for
+    /* TEXT RENDERING */
 
     /* LOAD TEXTURES */
-    unsigned int texture_earth = loadTexture("resources/planets/earth2k.jpg");
-    unsigned int t_sun = loadTexture("resources/planets/2k_sun.jpg");
-    unsigned int texture_moon = loadTexture("resources/planets/2k_moon.jpg");
-    unsigned int texture_mercury = loadTexture("resources/planets/2k_mercury.jpg");
-    unsigned int texture_venus = loadTexture("resources/planets/2k_mercury.jpg");
-    unsigned int texture_mars = loadTexture("resources/planets/2k_mars.jpg");
-    unsigned int texture_jupiter = loadTexture("resources/planets/2k_jupiter.jpg");
-    unsigned int texture_saturn = loadTexture("resources/planets/2k_saturn.jpg");
-    unsigned int texture_uranus = loadTexture("resources/planets/2k_uranus.jpg");
-    unsigned int texture_neptune = loadTexture("resources/planets/2k_neptune.jpg");
-    unsigned int texture_saturn_ring = loadTexture("resources/planets/r.jpg");
-    unsigned int texture_earth_clouds = loadTexture("resources/planets/2k_earth_clouds.jpg");
-
-    if (texture_earth == 0 || t_sun == 0 || texture_moon == 0 || texture_mercury == 0 ||
-        texture_venus == 0 || texture_mars == 0 || texture_jupiter == 0 || texture_saturn == 0 ||
-        texture_uranus == 0 || texture_neptune == 0 || texture_saturn_ring == 0 || texture_earth_clouds == 0)
-    {
-        std::cout << "Failed to load textures" << std::endl;
-        return -1;
-    }
+    // Images decode on the pool while the first frames render with placeholders,
+    // the pool is shared with the N-body mode
+    ThreadPool pool;
+    AssetLoader assets(pool);
+    TextureManager textures(assets);
+    double assetStart = glfwGetTime();
+
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
     /* LOAD TEXTURES */
 
     /* SPHERE GENERATION */
-    Sphere Sun(100.0f, 36 * 5, 18 * 5);
-    Sphere Mercury(10.0f, 36, 18);
-    Sphere Venus(12.0f, 36, 18);
-    Sphere Earth(11.8f, 36, 18);
-    Sphere Mars(8.0f, 36, 18);
-    Sphere Jupiter(40.0f, 36, 18);
-    Sphere Saturn(37.0f, 36, 18);
-    Sphere Uranus(30.0f, 36, 18);
-    Sphere Neptune(30.0f, 36, 19);
-    Sphere Moon(5.5f, 36, 18);
+    // Every body is an instance of a unit sphere scaled by its radius, with
+    // the tessellation picked from its size on screen
+    SphereLod sphereLods;
     /* SPHERE GENERATION */
 
+    /* CELESTIAL BODIES */
+    // Surface textures for the bodies of the solar system table
+    struct BodyLook
+    {
+        const char *Name;
+        const char *Texture;
+        const char *HighRes; // streamed in for close-ups, the texture is its preview
+    };
+    const BodyLook bodyLooks[] = {
+        {"Sun", "resources/planets/2k_sun.jpg", "resources/planets/8k_sun.jpg"},
+        {"Mercury", "resources/planets/2k_mercury.jpg", NULL},
+        {"Venus", "resources/planets/2k_mercury.jpg", NULL},
+        {"Earth", "resources/planets/earth2k.jpg", NULL},
+        {"Moon", "resources/planets/2k_moon.jpg", NULL},
+        {"Mars", "resources/planets/2k_mars.jpg", NULL},
+        {"Jupiter", "resources/planets/2k_jupiter.jpg", NULL},
+        {"Saturn", "resources/planets/2k_saturn.jpg", NULL},
+        {"Uranus", "resources/planets/2k_uranus.jpg", NULL},
+        {"Neptune", "resources/planets/2k_neptune.jpg", NULL},
+    };
+    BodyRegistry bodies;
+    std::vector<std::string> layerPaths;
+    MipStreamer streamer(pool);
+    std::vector<int> bodyStreams(SOLAR_SYSTEM_COUNT, -1); // streamed texture per body or -1
+    for (int i = 0; i < SOLAR_SYSTEM_COUNT; i++)
+    {
+        int body = bodies.Add(SOLAR_SYSTEM[i]);
+        if (body < 0)
+            continue;
+        for (const BodyLook &look : bodyLooks)
+        {
+            if (strcmp(look.Name, SOLAR_SYSTEM[i].Name) != 0)
+                continue;
+            // A streamed body takes its low mips from the preview texture
+            // and has no array layer, so the preview is decoded only once
+            if (look.HighRes)
+                bodyStreams[body] = streamer.Add(look.HighRes, look.Texture);
+            if (bodyStreams[body] >= 0)
+            {
+                bodies.TextureLayer[body] = -1.0f;
+                continue;
+            }
+            // Bodies sharing an image share its layer
+            size_t layer = 0;
+            while (layer < layerPaths.size() && layerPaths[layer] != look.Texture)
+                layer++;
+            if (layer == layerPaths.size())
+                layerPaths.push_back(look.Texture);
+            bodies.TextureLayer[body] = (float)layer;
+        }
+    }
+    // Surfaces load when a body is first seen, full size only for the closest ones
+    TextureResidency planetTextures(pool, layerPaths, PLANET_TEXTURE_WIDTH, PLANET_TEXTURE_HEIGHT);
+
+    // Per-instance model matrices and texture layers are streamed every frame
+    GLuint bodyModelVBO, bodyLayerVBO;
+    glGenBuffers(1, &bodyModelVBO);
+    glGenBuffers(1, &bodyLayerVBO);
+    std::vector<glm::mat4> bodyModels(bodies.Count());
+    std::vector<glm::vec3> bodyLayers(bodies.Count());
+    std::vector<int> bodyLods(bodies.Count(), 0); // sphere level per body, kept between frames
+    std::vector<int> instanceBodies;
+
+    // Scales of the 25 Saturn ring loops, with a gap after the 16th
+    std::vector<float> ringScales;
+    GLfloat rr = 0.55f;
+    for (int i = 0; i < 25; i++)
+    {
+        ringScales.push_back(rr);
+        rr += i == 15 ? 0.030f : 0.01f;
+    }
+
+    // Bounding spheres of everything drawn and their visibility, refilled every frame
+    BoundingSpheres cullSpheres;
+    std::vector<unsigned char> visible;
+    // Small bodies behind the large ones are skipped, one query each
+    OcclusionCuller occlusion(bodies.Count());
+    std::cout << "Orbit kernel: " << SimdLevelName(OrbitKernelLevel()) << std::endl;
+    std::cout << "Frustum culling: " << SimdLevelName(FrustumCullLevel()) << std::endl;
+
+    // Precomputed orbits from tools/make_ephemeris, optional
+    Ephemeris ephemeris;
+    const std::string ephemerisPath = "resources/ephemeris.bin";
+    if (AssetExists(ephemerisPath) && ephemeris.Load(ephemerisPath))
+    {
+        bodies.SetEphemeris(&ephemeris);
+        std::cout << "Ephemeris: orbit time " << ephemeris.StartTime() << " to " << ephemeris.EndTime() << std::endl;
+    }
+    const int earth = bodies.Find("Earth");
+    const int saturn = bodies.Find("Saturn");
+
+    // Planet cam for keys 1-8: body to track, camera distance from the parent and height
+    struct PlanetCam
+    {
+        int Body;
+        float Distance;
+        float Height;
+    };
+    const PlanetCam planetCams[8] = {
+        {bodies.Find("Mercury"), 100.0f * 3.5f * 1.3f, 50.0f},
+        {bodies.Find("Venus"), 100.0f * 4.5f * 1.2f, 50.0f},
+        {bodies.Find("Earth"), 100.0f * 5.5f * 1.2f, 50.0f},
+        {bodies.Find("Mars"), 100.0f * 6.0f * 1.2f, 20.0f},
+        {bodies.Find("Jupiter"), 100.0f * 7.5f * 1.3f, 50.0f},
+        {bodies.Find("Saturn"), 100.0f * 8.5f * 1.3f, 50.0f},
+        {bodies.Find("Uranus"), 100.0f * 9.5f * 1.3f, 50.0f},
+        {bodies.Find("Neptune"), 100.0f * 10.5f * 1.3f, 50.0f},
+    };
+    /* CELESTIAL BODIES */
+
+    /* SIMULATION CLOCK */
+    // Orbit time advances in fixed steps of 1/60 s worth of PlanetSpeed, at most
+    // four per frame. Spins stay on wall-clock time.
+    SimClock simClock(PlanetSpeed / 60.0, PlanetSpeed, 4);
+    /* SIMULATION CLOCK */
+
+    /* N-BODY MODE */
+    // Toggled with N. Simulation time is orbit time (seconds * PlanetSpeed)
+    // and G is calibrated so that Earth keeps its period under real gravity.
+    NBodySystem nbody;
+    nbody.G = (double)bodies.OrbitRate[earth] * bodies.OrbitRate[earth] *
+              pow((double)bodies.OrbitRadius[earth], 3.0);
+    nbody.Theta = 0.5;
+    nbody.Softening = 1.0;
+    const int beltParticles = 20000;
+    /* N-BODY MODE */
+
     std::vector<std::string> faces{
         "resources/skybox/starfield/starfield_rt.tga",
         "resources/skybox/starfield/starfield_lf.tga",
@@ -387,8 +563,11 @@ int main()
         "resources/skybox/blue/bkg1_back.png",
     };
 
-    unsigned int cubemapTexture = loadCubemap(faces);
-    unsigned int cubemapTextureExtra = loadCubemap(faces_extra);
+    // The blue environment only loads once E is pressed
+    CubemapCache skyboxes(textures, assets);
+    const int skybox = skyboxes.Add(faces);
+    const int skyboxExtra = skyboxes.Add(faces_extra);
+    skyboxes.Get(skybox, skybox, glfwGetTime()); // the default one loads with the other textures
     GLfloat camX = 10.0f;
     GLfloat camZ = 10.0f;
 
@@ -404,13 +583,50 @@ int main()
         glm::vec3(0.0f, 1.0f, 0.0f)   // Up
     );
 
-    glm::vec3 PlanetsPositions[9];
     while (!glfwWindowShouldClose(window))
     {
 
-        GLfloat currentFrame = (GLfloat)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        double currentTime = glfwGetTime();
+        deltaTime = (GLfloat)(currentTime - lastFrame);
+        lastFrame = currentTime;
+
+        /* ASSET STREAMING */
+        if (assets.Pending() > 0)
+        {
+            assets.Update();
+            if (assets.Pending() == 0 && assetStart >= 0.0)
+            {
+                std::cout << "Textures loaded in " << glfwGetTime() - assetStart << " s" << std::endl;
+                assetStart = -1.0; // later loads are on demand
+            }
+        }
+        skyboxes.Update(currentTime);
+        if (shaderReloader.Update())
+            configureShaders();
+        /* ASSET STREAMING */
+
+        /* SIMULATION CLOCK */
+        if (NBodyToggle)
+        {
+            NBodyToggle = false;
+            NBodyMode = !NBodyMode;
+            // Steps owed from before the switch are dropped, not run on the new state
+            simClock.Reset(simClock.Time());
+            if (NBodyMode)
+            {
+                bodies.Update(simClock.Time(), currentTime);
+                nbody.Clear();
+                bodies.Seed(nbody, simClock.Time());
+                AddAsteroidBelt(nbody, beltParticles);
+            }
+        }
+        int simSteps = simClock.Advance(currentTime);
+        if (NBodyMode)
+        {
+            for (int s = 0; s < simSteps; s++)
+                nbody.Step(simClock.StepSize, &pool);
+        }
+        /* SIMULATION CLOCK */
 
         /* ZOOM CONTROL */
         if (!camera.FreeCam)
@@ -451,350 +667,280 @@ int main()
 
         glm::mat4 model = glm::mat4(1.0f);
 
-        double viewX;
-        double viewZ;
-        glm::vec3 viewPos;
-
         SimpleShader.Use();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 10000.0f);
-        SimpleShader.setMat4("model", model);
-        SimpleShader.setMat4("view", view);
-        SimpleShader.setMat4("projection", projection);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, t_sun);
-
-        /* SUN */
-        glm::mat4 model_sun = glm::mat4(1.0f);
-        model_sun = glm::rotate(model_sun, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_sun = glm::rotate(model_sun, (GLfloat)glfwGetTime() * glm::radians(23.5f) * 0.25f, glm::vec3(0.0f, 0.0f, 1.f));
-        model_sun = glm::translate(model_sun, point);
-        SimpleShader.setMat4("model", model_sun);
-        Sun.Draw();
-        /* SUN */
-
-        /* MERCURY */
-        glm::mat4 model_mercury = glm::mat4(1.0f);
-        double xx = sin(glfwGetTime() * PlanetSpeed) * 100.0f * 2.0f * 1.3f;
-        double zz = cos(glfwGetTime() * PlanetSpeed) * 100.0f * 2.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_mercury);
-        model_mercury = glm::translate(model_mercury, point);
-        model_mercury = glm::rotate(model_mercury, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_mercury = glm::rotate(model_mercury, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_mercury = glm::translate(model_mercury, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[0] = glm::vec3(xx, 0.0f, zz);
-        model_mercury = glm::rotate(model_mercury, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_mercury = glm::rotate(model_mercury, (GLfloat)glfwGetTime() * glm::radians(-90.0f) * 0.05f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_mercury);
-        Mercury.Draw();
-        /* MERCURY */
-
-        /* VENUS */
-        glm::mat4 model_venus = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.75f) * 100.0f * 3.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.75f) * 100.0f * 3.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_venus);
-        model_venus = glm::translate(model_venus, point);
-        model_venus = glm::rotate(model_venus, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_venus = glm::rotate(model_venus, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_venus = glm::translate(model_venus, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[1] = glm::vec3(xx, 0.0f, zz);
-        model_venus = glm::rotate(model_venus, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_venus = glm::rotate(model_venus, glm::radians(-132.5f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_venus = glm::rotate(model_venus, (GLfloat)glfwGetTime() * glm::radians(-132.5f) * 0.012f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_venus);
-        Venus.Draw();
-        /* VENUS */
-
-        /* EARTH */
-        glm::mat4 model_earth = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.55f) * 100.0f * 4.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.55f) * 100.0f * 4.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_earth);
-        model_earth = glm::translate(model_earth, point);
-        model_earth = glm::rotate(model_earth, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_earth = glm::rotate(model_earth, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_earth = glm::translate(model_earth, glm::vec3(xx, 0.0f, zz));
-        glm::vec3 EarthPoint = glm::vec3(xx, 0.0f, zz);
-        PlanetsPositions[2] = glm::vec3(xx, 0.0f, zz);
-        model_earth = glm::rotate(model_earth, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_earth = glm::rotate(model_earth, glm::radians(-33.25f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_earth = glm::rotate(model_earth, (GLfloat)glfwGetTime() * glm::radians(-33.25f) * 2.0f, glm::vec3(0.0f, 0.0f, 1.f));
-        camera.LookAtPos = glm::vec3(model_earth[3][0], model_earth[3][1], model_earth[3][2]);
-        SimpleShader.setMat4("model", model_earth);
-        Earth.Draw();
-
-        /* EARTH */
-
-        /* MOON */
-        glm::mat4 model_moon = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 67.55f) * 100.0f * 0.5f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 67.55f) * 100.0f * 0.5f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_moon);
-        model_moon = glm::rotate(model_moon, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_moon = glm::rotate(model_moon, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_moon = glm::translate(model_moon, EarthPoint);
-        model_moon = glm::translate(model_moon, glm::vec3(xx, 0.0f, zz));
-        model_moon = glm::rotate(model_moon, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_moon = glm::rotate(model_moon, glm::radians(-32.4f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_moon = glm::rotate(model_moon, (GLfloat)glfwGetTime() * glm::radians(-32.4f) * 3.1f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_moon);
-        Moon.Draw();
-        /* MOON */
-
-        /* MARS */
-        glm::mat4 model_mars = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.35f) * 100.0f * 5.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.35f) * 100.0f * 5.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_mars);
-        model_mars = glm::translate(model_mars, point);
-        model_mars = glm::rotate(model_mars, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_mars = glm::rotate(model_mars, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_mars = glm::translate(model_mars, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[3] = glm::vec3(xx, 0.0f, zz);
-        model_mars = glm::rotate(model_mars, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_mars = glm::rotate(model_mars, glm::radians(-32.4f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_mars = glm::rotate(model_mars, (GLfloat)glfwGetTime() * glm::radians(-32.4f) * 2.1f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_mars);
-        Mars.Draw();
-        /* MARS */
-
-        /* JUPITER */
-        glm::mat4 model_jupiter = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.2f) * 100.0f * 6.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.2f) * 100.0f * 6.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_jupiter);
-        model_jupiter = glm::translate(model_jupiter, point);
-        model_jupiter = glm::rotate(model_jupiter, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_jupiter = glm::rotate(model_jupiter, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_jupiter = glm::translate(model_jupiter, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[4] = glm::vec3(xx, 0.0f, zz);
-        model_jupiter = glm::rotate(model_jupiter, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_jupiter = glm::rotate(model_jupiter, glm::radians(-23.5f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_jupiter = glm::rotate(model_jupiter, (GLfloat)glfwGetTime() * glm::radians(-23.5f) * 4.5f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_jupiter);
-        Jupiter.Draw();
-        /* JUPITER */
-
-        /* SATURN */
-        glm::mat4 model_saturn = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.15f) * 100.0f * 7.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.15f) * 100.0f * 7.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_saturn);
-        model_saturn = glm::translate(model_saturn, point);
-        model_saturn = glm::rotate(model_saturn, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_saturn = glm::rotate(model_saturn, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_saturn = glm::translate(model_saturn, glm::vec3(xx, 0.0f, zz));
-        glm::vec3 SatrunPoint = glm::vec3(xx, 0.0f, zz);
-        PlanetsPositions[5] = glm::vec3(xx, 0.0f, zz);
-        model_saturn = glm::rotate(model_saturn, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_saturn = glm::rotate(model_saturn, glm::radians(-34.7f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_saturn = glm::rotate(model_saturn, (GLfloat)glfwGetTime() * glm::radians(-34.7f) * 4.48f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_saturn);
-        Saturn.Draw();
-        /* SATURN */
-
-        /* URANUS */
-        glm::mat4 model_uranus = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.1f) * 100.0f * 8.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.1f) * 100.0f * 8.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_uranus);
-        model_uranus = glm::translate(model_uranus, point);
-        model_uranus = glm::rotate(model_uranus, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_uranus = glm::rotate(model_uranus, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_uranus = glm::translate(model_uranus, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[6] = glm::vec3(xx, 0.0f, zz);
-        model_uranus = glm::rotate(model_uranus, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_uranus = glm::rotate(model_uranus, glm::radians(-99.0f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_uranus = glm::rotate(model_uranus, (GLfloat)glfwGetTime() * glm::radians(-99.0f) * 4.5f, glm::vec3(0.0f, 0.0f, 1.f));
-        SimpleShader.setMat4("model", model_uranus);
-        Uranus.Draw();
-        /* URANUS */
-
-        /* NEPTUNE */
-        glm::mat4 model_neptune = glm::mat4(1.0f);
-        xx = sin(glfwGetTime() * PlanetSpeed * 0.08f) * 100.0f * 9.0f * 1.3f;
-        zz = cos(glfwGetTime() * PlanetSpeed * 0.08f) * 100.0f * 9.0f * 1.3f;
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_neptune);
-
-        model_neptune = glm::translate(model_neptune, point);
-        model_neptune = glm::rotate(model_neptune, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        model_neptune = glm::rotate(model_neptune, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        model_neptune = glm::translate(model_neptune, glm::vec3(xx, 0.0f, zz));
-        PlanetsPositions[7] = glm::vec3(xx, 0.0f, zz);
-        model_neptune = glm::rotate(model_neptune, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.f));
-        model_neptune = glm::rotate(model_neptune, glm::radians(-30.2f), glm::vec3(0.0f, 1.0f, 0.f));
-        model_neptune = glm::rotate(model_neptune, (GLfloat)glfwGetTime() * glm::radians(-30.2f) * 4.0f, glm::vec3(0.0f, 0.0f, 1.f));
-
-        SimpleShader.setMat4("model", model_neptune);
-        Neptune.Draw();
-        /* NEPTUNE */
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_venus);
+        SimpleShader.setMat4(simpleModel, model);
+
+        /* SCENE ROTATION */
+        glm::mat4 scene = glm::translate(glm::mat4(1.0f), point);
+        scene = glm::rotate(scene, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
+        scene = glm::rotate(scene, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
+        /* SCENE ROTATION */
+
+        /* FRAME CONSTANTS */
+        FrameConstants frame;
+        frame.View = view * scene;
+        frame.Projection = projection;
+        frame.SkyView = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+        frame.ScreenProjection = glm::ortho(0.0f, SCREEN_WIDTH, 0.0f, SCREEN_HEIGHT);
+        frame.Viewport = glm::vec4(SCREEN_WIDTH, SCREEN_HEIGHT, 1.0f / SCREEN_WIDTH, 1.0f / SCREEN_HEIGHT);
+        frameUniforms.Update(frame);
+        /* FRAME CONSTANTS */
+
+        /* BODIES */
+        // Analytic orbits are evaluated at the interpolated time, simulated ones are blended
+        bodies.Update(simClock.RenderTime(), currentTime);
+        if (NBodyMode)
+            bodies.SetPositions(nbody, simClock.Alpha());
+
+        /* CULLING */
+        // One bounding sphere per body, orbit loop and ring loop, tested
+        // together; everything outside the view is skipped before any draw state
+        Frustum frustum;
+        frustum.Extract(projection * frame.View);
+        cullSpheres.Clear();
+        for (int i = 0; i < bodies.Count(); i++)
+            cullSpheres.Add(bodies.Position[i], bodies.Radius[i]);
+        const int firstOrbit = cullSpheres.Count();
+        for (int i = 0; i < bodies.Count(); i++)
+        {
+            // The loop is centred between the foci and as wide as the semi-major axis
+            glm::vec3 center = glm::vec3(bodies.Orbit[i][3]);
+            if (bodies.Parent[i] >= 0)
+                center += bodies.Position[bodies.Parent[i]];
+            cullSpheres.Add(center, bodies.OrbitRadius[i]);
+        }
+        const int firstRing = cullSpheres.Count();
+        for (float scale : ringScales)
+            cullSpheres.Add(bodies.Position[saturn], scale * ORBIT_MESH_RADIUS);
+        visible.resize(cullSpheres.Count());
+        CullSpheres(frustum, cullSpheres, visible.data());
+        /* CULLING */
+
+        // Textures of the bodies in view are requested with their size on screen.
+        // The largest body on screen with a resident streamed texture samples
+        // it, other streamed bodies show the placeholder
+        int streamed = -1;
+        float streamedRadius = 0.0f;
+        for (int i = 0; i < bodies.Count(); i++)
+        {
+            if (!visible[i])
+                continue;
+            float radius = ScreenRadius(frame.View, projection, SCREEN_HEIGHT, bodies.Position[i], bodies.Radius[i]);
+            bodyLods[i] = sphereLods.Select(radius, bodyLods[i]);
+            if (bodyStreams[i] < 0)
+                planetTextures.Request((int)bodies.TextureLayer[i], radius);
+            else
+            {
+                streamer.Request(bodyStreams[i], radius);
+                if (streamer.ResidentWidth(bodyStreams[i]) > 0 && radius > streamedRadius)
+                {
+                    streamed = bodyStreams[i];
+                    streamedRadius = radius;
+                }
+            }
+        }
+        planetTextures.Update();
+        streamer.Update();
+
+        // Bodies in view become instances, either the occluders or the rest,
+        // grouped by sphere level so each level is one draw
+        auto drawBodies = [&](bool occluders) {
+            instanceBodies.clear();
+            for (int i = 0; i < bodies.Count(); i++)
+            {
+                if (!visible[i] || (bodies.Radius[i] >= OCCLUDER_RADIUS) != occluders)
+                    continue;
+                if (!occluders && !occlusion.Visible(i))
+                    continue;
+                instanceBodies.push_back(i);
+            }
+            if (instanceBodies.empty())
+                return;
+            std::stable_sort(instanceBodies.begin(), instanceBodies.end(),
+                             [&](int a, int b) { return bodyLods[a] < bodyLods[b]; });
+            const int instances = (int)instanceBodies.size();
+            for (int j = 0; j < instances; j++)
+            {
+                int i = instanceBodies[j];
+                bodyModels[j] = bodies.Model[i];
+                if (bodyStreams[i] >= 0)
+                    bodyLayers[j] = glm::vec3(planetTextures.PlaceholderLayer(), -1.0f,
+                                              streamed >= 0 && bodyStreams[i] == streamed ? 0.0f : -1.0f);
+                else
+                {
+                    int texture = (int)bodies.TextureLayer[i];
+                    bodyLayers[j] = glm::vec3(planetTextures.BaseLayer(texture), planetTextures.DetailLayer(texture),
+                                              -1.0f);
+                }
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, bodyModelVBO);
+            glBufferData(GL_ARRAY_BUFFER, instances * sizeof(glm::mat4), bodyModels.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, bodyLayerVBO);
+            glBufferData(GL_ARRAY_BUFFER, instances * sizeof(glm::vec3), bodyLayers.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            PlanetShader.Use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, planetTextures.BaseTexture());
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, planetTextures.DetailTexture());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, streamed >= 0 ? streamer.Texture(streamed) : 0);
+            // The spheres are closed and wound outward, so their far halves are skipped
+            glEnable(GL_CULL_FACE);
+            int first = 0;
+            while (first < instances)
+            {
+                const int level = bodyLods[instanceBodies[first]];
+                int last = first + 1;
+                while (last < instances && bodyLods[instanceBodies[last]] == level)
+                    last++;
+                sphereLods.Level(level).SetInstanceBuffers(bodyModelVBO, bodyLayerVBO, first);
+                sphereLods.Level(level).DrawInstanced(last - first);
+                first = last;
+            }
+            glDisable(GL_CULL_FACE);
+            glActiveTexture(GL_TEXTURE0);
+        };
+
+        /* OCCLUSION */
+        // The Sun and the gas giants are drawn first. Proxies of the smaller
+        // bodies are then tested against their depth, and a body whose last
+        // answered query passed no samples is left out of the second draw
+        occlusion.Collect();
+        drawBodies(true);
+        occlusion.BeginProxies(SimpleShader, simpleModel, glm::vec3(glm::inverse(frame.View) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+        for (int i = 0; i < bodies.Count(); i++)
+        {
+            if (visible[i] && bodies.Radius[i] < OCCLUDER_RADIUS)
+                occlusion.Query(i, bodies.Position[i], bodies.Radius[i]);
+        }
+        occlusion.EndProxies();
+        drawBodies(false);
+        /* OCCLUSION */
+        SimpleShader.Use();
+        camera.LookAtPos = glm::vec3(scene * glm::vec4(bodies.Position[earth], 1.0f));
+        /* BODIES */
 
         /* ORBITS */
-        glBindVertexArray(VAO_t);
-        glLineWidth(1.0f);
+        bool orbitsVisible = false;
+        for (int i = 0; i < bodies.Count(); i++)
+            orbitsVisible = orbitsVisible || (bodies.OrbitRadius[i] > 0.0f && visible[firstOrbit + i]);
         glm::mat4 modelorb;
-        for (float i = 2; i < 10; i++)
+        if (orbitsVisible)
         {
-            modelorb = glm::mat4(1);
-            modelorb = glm::translate(modelorb, point);
-            modelorb = glm::rotate(modelorb, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelorb = glm::rotate(modelorb, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelorb = glm::scale(modelorb, glm::vec3(i * 1.3f, i * 1.3f, i * 1.3f));
-            SimpleShader.setMat4("model", modelorb);
-            glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)orbVert.size() / 3);
+            // Orbit lines and rings are flat colours, the bodies come from texture arrays
+            SimpleShader.setVec3(simpleColor, 0.63f, 0.63f, 0.65f);
+            glBindVertexArray(VAO_t);
+            glLineWidth(1.0f);
+            for (int i = 0; i < bodies.Count(); i++)
+            {
+                if (bodies.OrbitRadius[i] <= 0.0f || !visible[firstOrbit + i])
+                    continue;
+                modelorb = glm::mat4(1);
+                if (bodies.Parent[i] >= 0)
+                    modelorb = glm::translate(modelorb, bodies.Position[bodies.Parent[i]]);
+                modelorb = modelorb * bodies.Orbit[i];
+                SimpleShader.setMat4(simpleModel, modelorb);
+                glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)orbVert.size() / 3);
+            }
         }
-        modelorb = glm::mat4(1);
-        modelorb = glm::rotate(modelorb, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-        modelorb = glm::rotate(modelorb, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-        modelorb = glm::translate(modelorb, EarthPoint);
-        modelorb = glm::scale(modelorb, glm::vec3(0.5f * 1.3f, 0.5f * 1.3f, 0.5f * 1.3f));
-        SimpleShader.setMat4("model", modelorb);
-        glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)orbVert.size() / 3);
         /* ORBITS */
 
         /* SATURN RINGS */
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_saturn_ring);
-        glLineWidth(2.0f);
-        GLfloat rr = 0.55f;
-        for (int i = 0; i < 25; i++)
+        // The outermost loop bounds the others
+        if (visible[firstRing + ringScales.size() - 1])
         {
-            modelorb = glm::mat4(1);
-
-            modelorb = glm::rotate(modelorb, glm::radians(SceneRotateY), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelorb = glm::rotate(modelorb, glm::radians(SceneRotateX), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelorb = glm::translate(modelorb, SatrunPoint);
-            modelorb = glm::rotate(modelorb, glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelorb = glm::scale(modelorb, glm::vec3(rr, rr, rr));
-            SimpleShader.setMat4("model", modelorb);
-            glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)orbVert.size() / 3);
-            if (i == 15)
-                rr += 0.030f;
-            else
-                rr += 0.01f;
+            SimpleShader.setVec3(simpleColor, 0.29f, 0.29f, 0.29f);
+            glBindVertexArray(VAO_t);
+            glLineWidth(2.0f);
+            for (size_t i = 0; i < ringScales.size(); i++)
+            {
+                if (!visible[firstRing + i])
+                    continue;
+                float rr = ringScales[i];
+                modelorb = glm::mat4(1);
+                modelorb = glm::translate(modelorb, bodies.Position[saturn]);
+                modelorb = glm::rotate(modelorb, glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+                modelorb = glm::scale(modelorb, glm::vec3(rr, rr, rr));
+                SimpleShader.setMat4(simpleModel, modelorb);
+                glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)orbVert.size() / 3);
+            }
         }
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_venus);
         glBindVertexArray(0);
         /* SATURN RINGS */
 
+        /* N-BODY PARTICLES */
+        if (NBodyMode)
+        {
+            beltVert.resize((nbody.Count() - bodies.Count()) * 3);
+            const double alpha = simClock.Alpha();
+            for (int i = bodies.Count(), j = 0; i < nbody.Count(); i++, j += 3)
+            {
+                double x, y, z;
+                nbody.Interpolate(i, alpha, x, y, z);
+                beltVert[j] = (float)x;
+                beltVert[j + 1] = (float)y;
+                beltVert[j + 2] = (float)z;
+            }
+            PointShader.Use();
+            PointShader.setVec3(pointColor, 0.6f, 0.55f, 0.5f);
+            glBindVertexArray(beltVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, beltVBO);
+            glBufferData(GL_ARRAY_BUFFER, beltVert.size() * sizeof(float), beltVert.data(), GL_STREAM_DRAW);
+            glPointSize(2.0f);
+            glDrawArrays(GL_POINTS, 0, (GLsizei)beltVert.size() / 3);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindVertexArray(0);
+        }
+        /* N-BODY PARTICLES */
+
         /* DRAW SKYBOX */
         glDepthFunc(GL_LEQUAL);
         SkyboxShader.Use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-        SkyboxShader.setMat4("view", view);
-        SkyboxShader.setMat4("projection", projection);
         // skybox cube
         glBindVertexArray(skyboxVAO);
         glActiveTexture(GL_TEXTURE0);
-        if (SkyBoxExtra)
-            glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureExtra);
-        else
-            glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxes.Get(SkyBoxExtra ? skyboxExtra : skybox, skybox, currentTime));
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
         glDepthFunc(GL_LESS);
         /* DRAW SKYBOX */
 
         /* PLANET TRACKING + SHOW INFO OF PLANET */
-        switch (PlanetView)
+        if (PlanetView > 0)
         {
-        case 1:
-            viewX = sin(glfwGetTime() * PlanetSpeed) * 100.0f * 3.5f * 1.3f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed) * 100.0f * 3.5f * 1.3f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[0], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 2:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.75f) * 100.0f * 4.5f * 1.2f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.75f) * 100.0f * 4.5f * 1.2f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[1], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 3:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.55f) * 100.0f * 5.5f * 1.2f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.55f) * 100.0f * 5.5f * 1.2f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[2], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 4:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.35f) * 100.0f * 6.0f * 1.2f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.35f) * 100.0f * 6.0f * 1.2f;
-            viewPos = glm::vec3(viewX, 20.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[3], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 5:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.2f) * 100.0f * 7.5f * 1.3f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.2f) * 100.0f * 7.5f * 1.3f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[4], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 6:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.15f) * 100.0f * 8.5f * 1.3f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.15f) * 100.0f * 8.5f * 1.3f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[5], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 7:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.1f) * 100.0f * 9.5f * 1.3f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.1f) * 100.0f * 9.5f * 1.3f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[6], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 8:
-            viewX = sin(glfwGetTime() * PlanetSpeed * 0.08f) * 100.0f * 10.5f * 1.3f;
-            viewZ = cos(glfwGetTime() * PlanetSpeed * 0.08f) * 100.0f * 10.5f * 1.3f;
-            viewPos = glm::vec3(viewX, 50.0f, viewZ);
-            view = glm::lookAt(viewPos, PlanetsPositions[7], glm::vec3(0.0f, 1.0f, 0.0f));
-            ShowInfo(TextShader);
-            break;
-
-        case 0:
+            // orbit the camera with the planet, further out along the same direction
+            const PlanetCam &pc = planetCams[PlanetView - 1];
+            glm::vec3 target = bodies.Position[pc.Body];
+            glm::vec3 outward = glm::normalize(glm::vec3(target.x, 0.0f, target.z));
+            glm::vec3 viewPos = target + outward * (pc.Distance - bodies.OrbitRadius[pc.Body]);
+            viewPos.y = target.y + pc.Height;
+            view = glm::lookAt(viewPos, target, glm::vec3(0.0f, 1.0f, 0.0f));
+            if (infoPlanet != PlanetView)
+            {
+                ShowInfo(hud, infoLabels);
+                infoPlanet = PlanetView;
+            }
+        }
+        else
             view = camera.GetViewMatrix();
 
-            RenderText(TextShader, "SOLAR SYSTEM ", 25.0f, SCREEN_HEIGHT - 30.0f, 0.50f, glm::vec3(0.7f, 0.7f, 0.11f));
-            RenderText(TextShader, "STARS: 1 (SUN) ", 25.0f, SCREEN_HEIGHT - 55.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-            RenderText(TextShader, "PLANETS: 8 (MAYBE 9) ", 25.0f, SCREEN_HEIGHT - 80.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-            RenderText(TextShader, "SATELLITES: 415 ", 25.0f, SCREEN_HEIGHT - 105.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-            RenderText(TextShader, "COMMETS: 3441 ", 25.0f, SCREEN_HEIGHT - 130.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-
-            if (camera.FreeCam)
-                RenderText(TextShader, "FREE CAM ", SCREEN_WIDTH - 200.0f, SCREEN_HEIGHT - 30.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-            if (onFreeCam)
-                RenderText(TextShader, "STATIC CAM ", SCREEN_WIDTH - 200.0f, SCREEN_HEIGHT - 30.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-            break;
-        }
-        if (PlanetView > 0)
-            RenderText(TextShader, "PLANET CAM ", SCREEN_WIDTH - 200.0f, SCREEN_HEIGHT - 30.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
+        // Labels are retained, only their visibility is decided per frame
+        for (int label : overviewLabels)
+            hud.SetLabelVisible(label, PlanetView == 0);
+        for (int label : infoLabels)
+            hud.SetLabelVisible(label, PlanetView > 0);
+        hud.SetLabelVisible(freeCamLabel, PlanetView == 0 && camera.FreeCam);
+        hud.SetLabelVisible(staticCamLabel, PlanetView == 0 && onFreeCam);
+        hud.SetLabelVisible(planetCamLabel, PlanetView > 0);
         /* PLANET TRACKING + SHOW INFO OF PLANET */
 
+        hud.SetViewport(SCREEN_WIDTH, SCREEN_HEIGHT);
+        hud.Flush(TextShader);
+        frameUniforms.EndFrame();
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
@@ -803,6 +949,11 @@ int main()
 
     glDeleteVertexArrays(1, &VAO_t);
     glDeleteBuffers(1, &VBO_t);
+    glDeleteVertexArrays(1, &beltVAO);
+    glDeleteBuffers(1, &beltVBO);
+    glDeleteBuffers(1, &bodyModelVBO);
+    glDeleteBuffers(1, &bodyLayerVBO);
+    shaderReloader.Stop();
     glfwTerminate();
     return 0;
 }
@@ -924,128 +1075,37 @@ void processInput(GLFWwindow *window)
     }
 }
 
-void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+// Massless test particles on circular orbits between Mars and Jupiter
+void AddAsteroidBelt(NBodySystem &sim, int count)
 {
-    glViewport(0, 0, width, height);
-}
-
-unsigned int loadCubemap(std::vector<std::string> faces)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-
-    for (unsigned int i = 0; i < faces.size(); i++)
+    std::mt19937 rng(1801);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < count; i++)
     {
-
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                         0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
+        double r = 690.0 + 60.0 * unit(rng);
+        double phi = TAU * unit(rng);
+        double h = 10.0 * (unit(rng) - 0.5);
+        double v = sqrt(sim.G / r);
+        sim.Add(r * sin(phi), h, r * cos(phi), v * cos(phi), 0.0, -v * sin(phi), 0.0);
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
 }
 
-unsigned int loadTexture(char const *path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-void RenderText(Shader &s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
-    // Activate corresponding render state
-    s.Use();
-    glUniform3f(glGetUniformLocation(s.ID, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
-
-    // Iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+    glViewport(0, 0, width, height);
+    // a minimised window reports 0 x 0, keep the last size for the projections
+    if (width > 0 && height > 0)
     {
-        Character ch = Characters[*c];
-
-        GLfloat xpos = x + ch.Bearing.x * scale;
-        GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-        GLfloat w = ch.Size.x * scale;
-        GLfloat h = ch.Size.y * scale;
-        // Update VBO for each character
-        GLfloat vertices[6][4] = {
-            {xpos, ypos + h, 0.0, 0.0},
-            {xpos, ypos, 0.0, 1.0},
-            {xpos + w, ypos, 1.0, 1.0},
-
-            {xpos, ypos + h, 0.0, 0.0},
-            {xpos + w, ypos, 1.0, 1.0},
-            {xpos + w, ypos + h, 1.0, 0.0}};
-        // Render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // Update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // Render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64)
+        SCREEN_WIDTH = (float)width;
+        SCREEN_HEIGHT = (float)height;
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void ShowInfo(Shader &s)
+// Fill the planet info labels from Info, only needed when the viewed planet changes
+void ShowInfo(TextRenderer &hud, const int labels[4])
 {
-    RenderText(s, "Planet: " + Info.Name, 25.0f, SCREEN_HEIGHT - 30.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-    RenderText(s, "Avarage Orbital Speed (km/s): " + Info.OrbitSpeed, 25.0f, SCREEN_HEIGHT - 50.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-    RenderText(s, "Mass (kg * 10^24): " + Info.Mass, 25.0f, SCREEN_HEIGHT - 70.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
-    RenderText(s, "Gravity (g): " + Info.Gravity, 25.0f, SCREEN_HEIGHT - 90.0f, 0.35f, glm::vec3(0.7f, 0.7f, 0.11f));
+    hud.SetLabelText(labels[0], "Planet: " + Info.Name);
+    hud.SetLabelText(labels[1], "Avarage Orbital Speed (km/s): " + Info.OrbitSpeed);
+    hud.SetLabelText(labels[2], "Mass (kg * 10^24): " + Info.Mass);
+    hud.SetLabelText(labels[3], "Gravity (g): " + Info.Gravity);
 }
\ No newline at end of file
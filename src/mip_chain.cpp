@@ -0,0 +1,57 @@
+#include "mip_chain.h"
+
+#include <algorithm>
+
+int MipLevelCount(int width, int height)
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        levels++;
+    return levels;
+}
+
+void HalveImage(const unsigned char *src, int width, int height, unsigned char *dst)
+{
+    int w = std::max(width / 2, 1), h = std::max(height / 2, 1);
+    for (int y = 0; y < h; y++)
+    {
+        int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < w; x++)
+        {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < 3; c++)
+            {
+                int sum = src[(y0 * width + x0) * 3 + c] + src[(y0 * width + x1) * 3 + c] +
+                          src[(y1 * width + x0) * 3 + c] + src[(y1 * width + x1) * 3 + c];
+                dst[(y * w + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+static void halveInPlace(std::vector<unsigned char> &pixels, int &width, int &height)
+{
+    std::vector<unsigned char> half((size_t)std::max(width / 2, 1) * std::max(height / 2, 1) * 3);
+    HalveImage(pixels.data(), width, height, half.data());
+    pixels.swap(half);
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+}
+
+bool ReduceImage(std::vector<unsigned char> &pixels, int &width, int &height, int targetWidth, int targetHeight)
+{
+    while (width > targetWidth || height > targetHeight)
+        halveInPlace(pixels, width, height);
+    return width == targetWidth && height == targetHeight;
+}
+
+void AppendMipChain(std::vector<unsigned char> &out, std::vector<unsigned char> image, int width, int height,
+                    int levelCount)
+{
+    out.insert(out.end(), image.begin(), image.end());
+    for (int level = 1; level < levelCount && (width > 1 || height > 1); level++)
+    {
+        halveInPlace(image, width, height);
+        out.insert(out.end(), image.begin(), image.end());
+    }
+}
@@ -0,0 +1,279 @@
+#include "mip_streamer.h"
+
+#include "asset_loader.h"
+#include "image_io.h"
+#include "mip_chain.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+MipStreamer::MipStreamer(ThreadPool &pool, size_t budgetBytes)
+    : pool(pool), budget(budgetBytes), memoryUsage(0), frame(0)
+{
+    glGenBuffers(1, &pixelBuffer);
+}
+
+MipStreamer::~MipStreamer()
+{
+    // Pool tasks fill jobs and lock this object's mutex
+    tasks.Wait();
+
+    glDeleteBuffers(1, &pixelBuffer);
+    for (const Entry &entry : entries)
+        glDeleteTextures(1, &entry.Texture);
+}
+
+int MipStreamer::Add(const std::string &path, const std::string &preview)
+{
+    Entry entry;
+    entry.Path = path;
+    if (!ReadImageSize(path, entry.Width, entry.Height))
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return -1;
+    }
+    entry.Levels = MipLevelCount(entry.Width, entry.Height);
+
+    // The low mips come from the preview when it is an exact level of the source
+    std::string source = path;
+    entry.Kept = entry.Levels - 1;
+    while (entry.Kept > 0 && std::max(entry.Width >> (entry.Kept - 1), 1) <= STREAM_INITIAL_WIDTH)
+        entry.Kept--;
+    int previewWidth, previewHeight;
+    if (!preview.empty() && ReadImageSize(preview, previewWidth, previewHeight))
+    {
+        int level = 0;
+        while (level < entry.Levels && std::max(entry.Width >> level, 1) > previewWidth)
+            level++;
+        if (std::max(entry.Width >> level, 1) == previewWidth && std::max(entry.Height >> level, 1) == previewHeight)
+        {
+            entry.Kept = level;
+            source = preview;
+        }
+        else
+            std::cout << "Preview " << preview << " is not a mip level of " << path << std::endl;
+    }
+    entry.Resident = entry.Levels;
+    entry.Wanted = entry.Levels - 1;
+
+    glGenTextures(1, &entry.Texture);
+    glBindTexture(GL_TEXTURE_2D, entry.Texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.Levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.Levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const int texture = (int)entries.size();
+    entries.push_back(entry);
+    queue(texture, entry.Kept, entry.Levels - 1, source);
+    return texture;
+}
+
+void MipStreamer::Request(int texture, float screenRadius)
+{
+    Entry &entry = entries[texture];
+    if (entry.LastRequested != frame)
+        entry.Wanted = entry.Levels - 1;
+    entry.LastRequested = frame;
+
+    // Across the visible hemisphere a level shows half its width over
+    // 2 * screenRadius pixels; the coarsest level that isn't magnified is needed
+    int level = entry.Levels - 1;
+    if (screenRadius > 0.0f)
+        level = std::max(0, std::min(level, (int)std::floor(std::log2(entry.Width / (4.0f * screenRadius)))));
+    entry.Wanted = std::min(entry.Wanted, level);
+}
+
+int MipStreamer::ResidentWidth(int texture) const
+{
+    const Entry &entry = entries[texture];
+    return entry.Resident < entry.Levels ? std::max(entry.Width >> entry.Resident, 1) : 0;
+}
+
+size_t MipStreamer::levelBytes(const Entry &entry, int level) const
+{
+    return (size_t)std::max(entry.Width >> level, 1) * std::max(entry.Height >> level, 1) * BYTES_PER_TEXEL;
+}
+
+void MipStreamer::Update()
+{
+    for (Entry &entry : entries)
+    {
+        if (entry.LastRequested != frame)
+            entry.Wanted = entry.Levels - 1;
+        if (entry.Wanted <= entry.Resident)
+            entry.LastNeeded = frame;
+        // Fine levels go once they have been unneeded for a while
+        if (!entry.Loading && frame - entry.LastNeeded > STREAM_RELEASE_FRAMES)
+        {
+            while (entry.Resident < std::min(entry.Wanted, entry.Kept))
+                release(entry);
+        }
+    }
+
+    for (int i = 0; i < (int)entries.size(); i++)
+    {
+        Entry &entry = entries[i];
+        if (entry.Loading || entry.Failed || entry.Wanted >= entry.Resident)
+            continue;
+
+        // Make room by releasing the finest levels of the least recently
+        // needed other textures, then settle for what fits
+        size_t bytes = 0;
+        for (int level = entry.Wanted; level < entry.Resident; level++)
+            bytes += levelBytes(entry, level);
+        while (memoryUsage + bytes > budget)
+        {
+            Entry *victim = NULL;
+            for (Entry &other : entries)
+            {
+                if (&other != &entry && !other.Loading && other.Resident < other.Kept &&
+                    other.LastNeeded < frame && (!victim || other.LastNeeded < victim->LastNeeded))
+                    victim = &other;
+            }
+            if (!victim)
+                break;
+            release(*victim);
+        }
+        int first = entry.Wanted;
+        while (first < entry.Resident && memoryUsage + bytes > budget)
+        {
+            bytes -= levelBytes(entry, first);
+            first++;
+        }
+        if (first < entry.Resident)
+            queue(i, first, entry.Resident - 1, entry.Path);
+    }
+
+    size_t uploaded = 0;
+    for (size_t i = 0; i < jobs.size() && uploaded < ASSET_UPLOAD_BUDGET;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!jobs[i]->Done)
+            {
+                i++;
+                continue;
+            }
+        }
+        Job &job = *jobs[i];
+        Entry &entry = entries[job.Texture];
+        if (!job.Failed)
+            uploaded += upload(job, ASSET_UPLOAD_BUDGET - uploaded);
+        if (job.Failed || job.Level < job.First)
+        {
+            entry.Loading = false;
+            entry.Failed = entry.Failed || job.Failed;
+            jobs.erase(jobs.begin() + i);
+        }
+        else
+            i++;
+    }
+
+    frame++;
+}
+
+void MipStreamer::queue(int texture, int first, int last, const std::string &source)
+{
+    Entry &entry = entries[texture];
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->Texture = texture;
+    job->First = first;
+    job->Last = last;
+    job->Source = source;
+    entry.Loading = true;
+    jobs.push_back(job);
+
+    const int width = std::max(entry.Width >> first, 1), height = std::max(entry.Height >> first, 1);
+    tasks.Submit(pool, [this, job, width, height]() {
+        std::vector<unsigned char> image;
+        int w, h;
+        if (!DecodeImageRGB(job->Source, image, w, h))
+            job->Failed = true;
+        else if (ReduceImage(image, w, h, width, height))
+        {
+            for (int level = job->First; level <= job->Last; level++)
+            {
+                job->Levels.push_back(image);
+                ReduceImage(image, w, h, std::max(w / 2, 1), std::max(h / 2, 1));
+            }
+        }
+        else
+        {
+            std::cout << "Texture " << job->Source << " does not reduce to " << width << "x" << height << std::endl;
+            job->Failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        job->Done = true;
+    });
+}
+
+// Copies rows of the job's current level through the pixel buffer until the
+// byte budget is spent, and makes each finished level the new base level
+size_t MipStreamer::upload(Job &job, size_t budgetBytes)
+{
+    Entry &entry = entries[job.Texture];
+    if (job.Level < 0)
+        job.Level = job.Last;
+
+    size_t uploaded = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, entry.Texture);
+    while (job.Level >= job.First && uploaded < budgetBytes)
+    {
+        const int w = std::max(entry.Width >> job.Level, 1), h = std::max(entry.Height >> job.Level, 1);
+        const std::vector<unsigned char> &pixels = job.Levels[job.Level - job.First];
+        if (job.Row == 0)
+        {
+            glTexImage2D(GL_TEXTURE_2D, job.Level, GL_RGB8, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+            memoryUsage += levelBytes(entry, job.Level);
+        }
+
+        const size_t rowBytes = (size_t)w * 3;
+        const int rows = std::min(h - job.Row, (int)std::max<size_t>(1, (budgetBytes - uploaded) / rowBytes));
+        const size_t bytes = rows * rowBytes;
+        if (!StagePixels(pixelBuffer, pixels.data() + job.Row * rowBytes, bytes))
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            std::cout << "Failed to map the pixel buffer for " << entry.Path << std::endl;
+            job.Failed = true;
+            break;
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, job.Level, 0, job.Row, w, rows, GL_RGB, GL_UNSIGNED_BYTE, (void *)0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uploaded += bytes;
+        job.Row += rows;
+
+        if (job.Row == h)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.Level);
+            entry.Resident = job.Level;
+            entry.LastNeeded = frame;
+            std::vector<unsigned char>().swap(job.Levels[job.Level - job.First]);
+            job.Level--;
+            job.Row = 0;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return uploaded;
+}
+
+// Drops the finest resident level, raising the base level first so the
+// texture stays complete
+void MipStreamer::release(Entry &entry)
+{
+    const int level = entry.Resident;
+    glBindTexture(GL_TEXTURE_2D, entry.Texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, 0, 0, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    memoryUsage -= levelBytes(entry, level);
+    entry.Resident = level + 1;
+}
@@ -0,0 +1,319 @@
+#include "nbody.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const int MORTON_BITS = 21;
+
+// Insert two zero bits between each of the low 21 bits
+uint64_t SpreadBits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+uint64_t Quantize(double v, double min, double scale)
+{
+    double q = (v - min) * scale;
+    if (q < 0.0)
+        q = 0.0;
+    if (q > (double)((1 << MORTON_BITS) - 1))
+        q = (double)((1 << MORTON_BITS) - 1);
+    return (uint64_t)q;
+}
+} // namespace
+
+NBodySystem::NBodySystem()
+    : G(1.0), Theta(0.5), Softening(0.01), LeafSize(8), Integrator(NBODY_LEAPFROG), forcesValid(false)
+{
+}
+
+int NBodySystem::Add(double x, double y, double z, double vx, double vy, double vz, double mass)
+{
+    X.push_back(x);
+    Y.push_back(y);
+    Z.push_back(z);
+    VX.push_back(vx);
+    VY.push_back(vy);
+    VZ.push_back(vz);
+    AX.push_back(0.0);
+    AY.push_back(0.0);
+    AZ.push_back(0.0);
+    Mass.push_back(mass);
+    PX.push_back(x);
+    PY.push_back(y);
+    PZ.push_back(z);
+    forcesValid = false;
+    return Count() - 1;
+}
+
+void NBodySystem::Clear()
+{
+    for (std::vector<double> *v : {&X, &Y, &Z, &VX, &VY, &VZ, &AX, &AY, &AZ, &Mass, &PX, &PY, &PZ})
+        v->clear();
+    nodes.clear();
+    forcesValid = false;
+}
+
+void NBodySystem::buildTree()
+{
+    nodes.clear();
+    const int n = Count();
+    if (n == 0)
+        return;
+
+    // Cubic bounds around every body
+    double minX = X[0], minY = Y[0], minZ = Z[0];
+    double maxX = X[0], maxY = Y[0], maxZ = Z[0];
+    for (int i = 1; i < n; i++)
+    {
+        minX = std::min(minX, X[i]);
+        minY = std::min(minY, Y[i]);
+        minZ = std::min(minZ, Z[i]);
+        maxX = std::max(maxX, X[i]);
+        maxY = std::max(maxY, Y[i]);
+        maxZ = std::max(maxZ, Z[i]);
+    }
+    double size = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ)) * 1.0001 + 1e-9;
+    double scale = (double)(1 << MORTON_BITS) / size;
+
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t key = SpreadBits(Quantize(X[i], minX, scale)) |
+                       SpreadBits(Quantize(Y[i], minY, scale)) << 1 |
+                       SpreadBits(Quantize(Z[i], minZ, scale)) << 2;
+        order[i] = std::make_pair(key, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    sourceKey.clear();
+    sourceIndex.clear();
+    sx.clear();
+    sy.clear();
+    sz.clear();
+    sm.clear();
+    for (const std::pair<uint64_t, int> &o : order)
+    {
+        int i = o.second;
+        if (Mass[i] <= 0.0)
+            continue;
+        sourceKey.push_back(o.first);
+        sourceIndex.push_back(i);
+        sx.push_back(X[i]);
+        sy.push_back(Y[i]);
+        sz.push_back(Z[i]);
+        sm.push_back(Mass[i]);
+    }
+
+    if (!sourceKey.empty())
+        buildNode(0, (int)sourceKey.size(), 0, size);
+}
+
+int NBodySystem::buildNode(int begin, int end, int level, double size)
+{
+    int id = (int)nodes.size();
+    nodes.push_back(Node());
+
+    double mass = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+    bool leaf = end - begin <= LeafSize || level == MORTON_BITS;
+    if (leaf)
+    {
+        for (int k = begin; k < end; k++)
+        {
+            mass += sm[k];
+            mx += sm[k] * sx[k];
+            my += sm[k] * sy[k];
+            mz += sm[k] * sz[k];
+        }
+    }
+    else
+    {
+        // Sources sharing the next three key bits form one octant, in key order
+        int shift = 3 * (MORTON_BITS - 1 - level);
+        int b = begin;
+        while (b < end)
+        {
+            uint64_t octant = sourceKey[b] >> shift;
+            int e = b + 1;
+            while (e < end && (sourceKey[e] >> shift) == octant)
+                e++;
+
+            int child = buildNode(b, e, level + 1, size * 0.5);
+            const Node &c = nodes[child];
+            mass += c.Mass;
+            mx += c.Mass * c.X;
+            my += c.Mass * c.Y;
+            mz += c.Mass * c.Z;
+            b = e;
+        }
+    }
+
+    Node &node = nodes[id];
+    node.Mass = mass;
+    node.X = mx / mass;
+    node.Y = my / mass;
+    node.Z = mz / mass;
+    node.Size = size;
+    node.First = begin;
+    node.Count = end - begin;
+    node.Next = (int)nodes.size();
+    node.Leaf = leaf;
+    return id;
+}
+
+void NBodySystem::accumulate(int self, double &ax, double &ay, double &az) const
+{
+    const double px = X[self], py = Y[self], pz = Z[self];
+    const double eps2 = Softening * Softening;
+    const double theta2 = Theta * Theta;
+    const int count = (int)nodes.size();
+
+    ax = ay = az = 0.0;
+    int n = 0;
+    while (n < count)
+    {
+        const Node &node = nodes[n];
+        if (node.Leaf)
+        {
+            for (int k = node.First; k < node.First + node.Count; k++)
+            {
+                if (sourceIndex[k] == self)
+                    continue;
+                double dx = sx[k] - px, dy = sy[k] - py, dz = sz[k] - pz;
+                double r2 = dx * dx + dy * dy + dz * dz + eps2;
+                double inv = 1.0 / std::sqrt(r2);
+                double f = sm[k] * inv * inv * inv;
+                ax += f * dx;
+                ay += f * dy;
+                az += f * dz;
+            }
+            n = node.Next;
+            continue;
+        }
+
+        double dx = node.X - px, dy = node.Y - py, dz = node.Z - pz;
+        double r2 = dx * dx + dy * dy + dz * dz;
+        if (node.Size * node.Size < theta2 * r2)
+        {
+            // Far enough away to be treated as a point mass
+            r2 += eps2;
+            double inv = 1.0 / std::sqrt(r2);
+            double f = node.Mass * inv * inv * inv;
+            ax += f * dx;
+            ay += f * dy;
+            az += f * dz;
+            n = node.Next;
+        }
+        else
+        {
+            n++;
+        }
+    }
+
+    ax *= G;
+    ay *= G;
+    az *= G;
+}
+
+void NBodySystem::ComputeForces(ThreadPool *pool)
+{
+    buildTree();
+
+    // Walk targets in Morton order so neighbouring threads touch the same nodes
+    auto range = [this](int begin, int end) {
+        for (int j = begin; j < end; j++)
+        {
+            int i = order[j].second;
+            accumulate(i, AX[i], AY[i], AZ[i]);
+        }
+    };
+    if (pool)
+        pool->ParallelFor(Count(), 256, range);
+    else
+        range(0, Count());
+
+    forcesValid = true;
+}
+
+void NBodySystem::kick(double dt)
+{
+    const int n = Count();
+    for (int i = 0; i < n; i++)
+    {
+        VX[i] += AX[i] * dt;
+        VY[i] += AY[i] * dt;
+        VZ[i] += AZ[i] * dt;
+    }
+}
+
+void NBodySystem::drift(double dt)
+{
+    const int n = Count();
+    for (int i = 0; i < n; i++)
+    {
+        X[i] += VX[i] * dt;
+        Y[i] += VY[i] * dt;
+        Z[i] += VZ[i] * dt;
+    }
+}
+
+void NBodySystem::leapfrog(double dt, ThreadPool *pool)
+{
+    kick(0.5 * dt);
+    drift(dt);
+    ComputeForces(pool);
+    kick(0.5 * dt);
+}
+
+void NBodySystem::Step(double dt, ThreadPool *pool)
+{
+    if (!forcesValid)
+        ComputeForces(pool);
+
+    PX = X;
+    PY = Y;
+    PZ = Z;
+
+    if (Integrator == NBODY_YOSHIDA4)
+    {
+        // Yoshida (1990) triple jump, the middle step runs backwards in time
+        const double cbrt2 = 1.2599210498948731648;
+        const double w1 = 1.0 / (2.0 - cbrt2);
+        const double w0 = -cbrt2 / (2.0 - cbrt2);
+        leapfrog(w1 * dt, pool);
+        leapfrog(w0 * dt, pool);
+        leapfrog(w1 * dt, pool);
+    }
+    else
+        leapfrog(dt, pool);
+}
+
+double NBodySystem::Energy() const
+{
+    const int n = Count();
+    const double eps2 = Softening * Softening;
+    double kinetic = 0.0, potential = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        kinetic += 0.5 * Mass[i] * (VX[i] * VX[i] + VY[i] * VY[i] + VZ[i] * VZ[i]);
+        if (Mass[i] <= 0.0)
+            continue;
+        for (int j = i + 1; j < n; j++)
+        {
+            if (Mass[j] <= 0.0)
+                continue;
+            double dx = X[j] - X[i], dy = Y[j] - Y[i], dz = Z[j] - Z[i];
+            potential -= G * Mass[i] * Mass[j] / std::sqrt(dx * dx + dy * dy + dz * dz + eps2);
+        }
+    }
+    return kinetic + potential;
+}
@@ -0,0 +1,92 @@
+#include "occlusion_culler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Proxy faces sit inside the unit sphere, so the proxy is scaled up to
+// always cover the body
+static float proxyScale()
+{
+    static const float scale = 1.0f / InscribedRadius(GenerateIcosphere(1.0f, OCCLUSION_PROXY_SUBDIVISIONS));
+    return scale;
+}
+
+OcclusionCuller::OcclusionCuller(int count)
+    : queries(count), pending(count, false), visible(count, true), lastQuery(count, -1), frame(0), hidden(0),
+      proxy(GenerateIcosphere(proxyScale(), OCCLUSION_PROXY_SUBDIVISIONS)), shader(nullptr), eye(0.0f)
+{
+    glGenQueries(count, queries.data());
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    glDeleteQueries((GLsizei)queries.size(), queries.data());
+}
+
+void OcclusionCuller::Collect()
+{
+    frame++;
+    hidden = 0;
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        if (pending[i])
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &samples);
+                visible[i] = samples != 0;
+                pending[i] = false;
+            }
+        }
+        if (!Visible((int)i))
+            hidden++;
+    }
+}
+
+bool OcclusionCuller::Visible(int body) const
+{
+    return visible[body] || lastQuery[body] < frame - 1;
+}
+
+void OcclusionCuller::BeginProxies(const Shader &proxyShader, UniformHandle modelUniform, const glm::vec3 &eyePosition)
+{
+    shader = &proxyShader;
+    model = modelUniform;
+    eye = eyePosition;
+    shader->Use();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+}
+
+void OcclusionCuller::Query(int body, const glm::vec3 &center, float radius)
+{
+    // A body that went unqueried starts over as visible
+    if (lastQuery[body] < frame - 1)
+        visible[body] = true;
+    lastQuery[body] = frame;
+
+    // With the camera inside the proxy the near plane clips it away
+    if (glm::length(center - eye) < radius * proxyScale() + 1.0f)
+    {
+        visible[body] = true;
+        return;
+    }
+    if (pending[body])
+        return;
+
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), center);
+    transform = glm::scale(transform, glm::vec3(radius));
+    shader->setMat4(model, transform);
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[body]);
+    proxy.Draw();
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    pending[body] = true;
+}
+
+void OcclusionCuller::EndProxies()
+{
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+}
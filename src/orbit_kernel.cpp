@@ -0,0 +1,145 @@
+#include "orbit_kernel.h"
+
+#include <cstddef>
+
+namespace
+{
+// Model matrix = translate(orbit position) * rotateX(-90) * rotateY(tilt) * rotateZ(spin) * scale,
+// expanded by hand so only the two sin/cos pairs depend on time.
+void EvaluateScalar(const OrbitBatch &b, double orbitTime, double spinTime, float *out, int first)
+{
+    for (int i = first; i < b.Count; i++)
+    {
+        float os, oc, ss, sc;
+        simd::SinCos(simd::ReducePhase(orbitTime * b.OrbitRate[i]), os, oc);
+        simd::SinCos(simd::ReducePhase(spinTime * b.SpinRate[i]), ss, sc);
+
+        float s = b.Scale[i];
+        float tc = b.TiltCos[i] * s;
+        float ts = b.TiltSin[i] * s;
+        float r = b.OrbitRadius[i];
+        float *m = out + (size_t)i * 16;
+
+        m[0] = tc * sc;
+        m[1] = -(ts * sc);
+        m[2] = -(s * ss);
+        m[3] = 0.0f;
+        m[4] = -(tc * ss);
+        m[5] = ts * ss;
+        m[6] = -(s * sc);
+        m[7] = 0.0f;
+        m[8] = ts;
+        m[9] = tc;
+        m[10] = 0.0f;
+        m[11] = 0.0f;
+        m[12] = r * os;
+        m[13] = 0.0f;
+        m[14] = r * oc;
+        m[15] = 1.0f;
+    }
+}
+
+#if SIMD_X86
+// Lanes hold one matrix column for four consecutive bodies, transpose and scatter them
+SIMD_TARGET_SSE2 inline void StoreColumn4(float *out, int column, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(out + column * 4, x);
+    _mm_storeu_ps(out + 16 + column * 4, y);
+    _mm_storeu_ps(out + 32 + column * 4, z);
+    _mm_storeu_ps(out + 48 + column * 4, w);
+}
+
+SIMD_TARGET_SSE2 void EvaluateSSE2(const OrbitBatch &b, double orbitTime, double spinTime, float *out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    int i = 0;
+    for (; i + 4 <= b.Count; i += 4)
+    {
+        __m128 os, oc, ss, sc;
+        simd::SinCos4(simd::Phase4(b.OrbitRate + i, orbitTime), os, oc);
+        simd::SinCos4(simd::Phase4(b.SpinRate + i, spinTime), ss, sc);
+
+        __m128 s = _mm_loadu_ps(b.Scale + i);
+        __m128 tc = _mm_mul_ps(_mm_loadu_ps(b.TiltCos + i), s);
+        __m128 ts = _mm_mul_ps(_mm_loadu_ps(b.TiltSin + i), s);
+        __m128 r = _mm_loadu_ps(b.OrbitRadius + i);
+        float *m = out + (size_t)i * 16;
+
+        StoreColumn4(m, 0, _mm_mul_ps(tc, sc), _mm_sub_ps(zero, _mm_mul_ps(ts, sc)), _mm_sub_ps(zero, _mm_mul_ps(s, ss)), zero);
+        StoreColumn4(m, 1, _mm_sub_ps(zero, _mm_mul_ps(tc, ss)), _mm_mul_ps(ts, ss), _mm_sub_ps(zero, _mm_mul_ps(s, sc)), zero);
+        StoreColumn4(m, 2, ts, tc, zero, zero);
+        StoreColumn4(m, 3, _mm_mul_ps(r, os), zero, _mm_mul_ps(r, oc), one);
+    }
+    EvaluateScalar(b, orbitTime, spinTime, out, i);
+}
+
+SIMD_TARGET_AVX2 inline void StoreColumn8(float *out, int column, __m256 x, __m256 y, __m256 z, __m256 w)
+{
+    StoreColumn4(out, column, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+                 _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+    StoreColumn4(out + 64, column, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+                 _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+}
+
+SIMD_TARGET_AVX2 void EvaluateAVX2(const OrbitBatch &b, double orbitTime, double spinTime, float *out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    int i = 0;
+    for (; i + 8 <= b.Count; i += 8)
+    {
+        __m256 os, oc, ss, sc;
+        simd::SinCos8(simd::Phase8(b.OrbitRate + i, orbitTime), os, oc);
+        simd::SinCos8(simd::Phase8(b.SpinRate + i, spinTime), ss, sc);
+
+        __m256 s = _mm256_loadu_ps(b.Scale + i);
+        __m256 tc = _mm256_mul_ps(_mm256_loadu_ps(b.TiltCos + i), s);
+        __m256 ts = _mm256_mul_ps(_mm256_loadu_ps(b.TiltSin + i), s);
+        __m256 r = _mm256_loadu_ps(b.OrbitRadius + i);
+        float *m = out + (size_t)i * 16;
+
+        StoreColumn8(m, 0, _mm256_mul_ps(tc, sc), _mm256_sub_ps(zero, _mm256_mul_ps(ts, sc)), _mm256_sub_ps(zero, _mm256_mul_ps(s, ss)), zero);
+        StoreColumn8(m, 1, _mm256_sub_ps(zero, _mm256_mul_ps(tc, ss)), _mm256_mul_ps(ts, ss), _mm256_sub_ps(zero, _mm256_mul_ps(s, sc)), zero);
+        StoreColumn8(m, 2, ts, tc, zero, zero);
+        StoreColumn8(m, 3, _mm256_mul_ps(r, os), zero, _mm256_mul_ps(r, oc), one);
+    }
+    EvaluateScalar(b, orbitTime, spinTime, out, i);
+}
+#endif
+} // namespace
+
+SimdLevel OrbitKernelLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+void EvaluateOrbits(const OrbitBatch &batch, double orbitTime, double spinTime, float *instances)
+{
+    EvaluateOrbits(batch, orbitTime, spinTime, instances, OrbitKernelLevel());
+}
+
+void EvaluateOrbits(const OrbitBatch &batch, double orbitTime, double spinTime, float *instances, SimdLevel level)
+{
+    if (level > OrbitKernelLevel())
+        level = OrbitKernelLevel();
+
+    switch (level)
+    {
+#if SIMD_X86
+    case SIMD_AVX2:
+        EvaluateAVX2(batch, orbitTime, spinTime, instances);
+        break;
+    case SIMD_SSE2:
+        EvaluateSSE2(batch, orbitTime, spinTime, instances);
+        break;
+#endif
+    default:
+        EvaluateScalar(batch, orbitTime, spinTime, instances, 0);
+        break;
+    }
+}
@@ -0,0 +1,155 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// From ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+typedef void(APIENTRYP PFNGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                               GLenum *binaryFormat, void *binary);
+typedef void(APIENTRYP PFNPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary,
+                                            GLsizei length);
+typedef void(APIENTRYP PFNPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+static PFNGETPROGRAMBINARYPROC getProgramBinary = NULL;
+static PFNPROGRAMBINARYPROC programBinary = NULL;
+static PFNPROGRAMPARAMETERIPROC programParameteri = NULL;
+
+static std::string cachePath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return std::string(PROGRAM_CACHE_DIRECTORY) + "/" + name;
+}
+
+void InitProgramCache(GLADloadproc load)
+{
+    getProgramBinary = (PFNGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    programBinary = (PFNPROGRAMBINARYPROC)load("glProgramBinary");
+    programParameteri = (PFNPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+
+    // Some loaders return non-null stubs, the format count is what tells
+    GLint formats = 0;
+    if (getProgramBinary && programBinary && programParameteri)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    if (formats <= 0)
+    {
+        getProgramBinary = NULL;
+        programBinary = NULL;
+        programParameteri = NULL;
+        std::cout << "Program binaries are not supported, shaders compile every launch" << std::endl;
+    }
+}
+
+bool ProgramCacheEnabled()
+{
+    return getProgramBinary != NULL;
+}
+
+uint64_t ProgramCacheKey(const std::vector<std::string> &sources)
+{
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const char *data, size_t size) {
+        for (size_t i = 0; i < size; i++)
+            h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+        // Separator, so moving text between strings changes the key
+        h = (h ^ 0xff) * 1099511628211ull;
+    };
+    for (const std::string &source : sources)
+        mix(source.data(), source.size());
+    const GLenum driver[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : driver)
+    {
+        const char *text = (const char *)glGetString(name);
+        mix(text ? text : "", text ? strlen(text) : 0);
+    }
+    return h;
+}
+
+void PrepareProgramBinary(GLuint program)
+{
+    if (ProgramCacheEnabled())
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool LoadProgramBinary(GLuint program, uint64_t key)
+{
+    if (!ProgramCacheEnabled())
+        return false;
+    std::ifstream file(cachePath(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    ProgramCacheHeader header;
+    if (!file.read((char *)&header, sizeof(header)) ||
+        memcmp(header.Magic, PROGRAM_CACHE_MAGIC, sizeof(header.Magic)) != 0 || header.Key != key)
+        return false;
+    // The length must match what follows the header before it is trusted
+    // for an allocation, a corrupt entry would otherwise ask for up to 4 GB
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff end = file.tellg();
+    if (start < 0 || end < 0 || (uint64_t)(end - start) != header.Length || header.Length == 0)
+        return false;
+    file.seekg(start);
+    std::vector<char> binary(header.Length);
+    if (!file.read(binary.data(), binary.size()))
+        return false;
+
+    // The driver may still refuse it, e.g. after an update that kept the version string
+    programBinary(program, header.Format, binary.data(), (GLsizei)binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    return linked == GL_TRUE;
+}
+
+void SaveProgramBinary(GLuint program, uint64_t key)
+{
+    if (!ProgramCacheEnabled())
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    ProgramCacheHeader header;
+    memcpy(header.Magic, PROGRAM_CACHE_MAGIC, sizeof(header.Magic));
+    header.Key = key;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+    header.Format = format;
+    header.Length = (uint32_t)written;
+
+    // Written aside and renamed, so a crash never leaves a truncated entry
+    std::error_code error;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIRECTORY, error);
+    const std::string path = cachePath(key);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write((const char *)&header, sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+        {
+            std::cout << "Failed to write " << temporary << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::cout << "Failed to write " << path << ": " << error.message() << std::endl;
+}
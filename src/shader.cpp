@@ -1,48 +1,136 @@
 #include "shader.h"
+#include "asset_pack.h"
+#include "program_cache.h"
 
 #include <../external/glad/include/glad/glad.h>
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath)
+// Source text from the mounted asset pack, or from the loose file. Loose
+// files win when looseFirst is set, so edits show up while a pack is mounted.
+static std::string readSource(const char *path, bool looseFirst)
 {
-    std::string vertexCode, fragmentCode, geometryCode;
+    AssetView packed = FindAsset(path);
+    if (packed.Valid() && !(looseFirst && std::filesystem::exists(path)))
+        return std::string((const char *)packed.Data, packed.Size);
 
-    try
+    std::ifstream file(path);
+    if (!file.is_open())
+        throw std::runtime_error(std::string("Failed to open shader file ") + path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// "A B=2" -> "#define A\n#define B 2\n", names may also be separated by commas
+static std::string permutationDefines(const std::string &permutation)
+{
+    std::string names = permutation;
+    std::replace(names.begin(), names.end(), ',', ' ');
+    std::istringstream stream(names);
+    std::string defines, name;
+    while (stream >> name)
     {
-        std::ifstream vShaderFile(vertexPath);
-        std::ifstream fShaderFile(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
+        size_t equals = name.find('=');
+        if (equals == std::string::npos)
+            defines += "#define " + name + "\n";
+        else
+            defines += "#define " + name.substr(0, equals) + " " + name.substr(equals + 1) + "\n";
+    }
+    return defines;
+}
 
-        if (!vShaderFile.is_open() || !fShaderFile.is_open())
-            throw std::runtime_error("Failed to open vertex or fragment shader file.");
+// Appends the source at path to out with its #include "file" lines expanded,
+// files resolved next to the one including them. Includes are expanded
+// wherever they appear, also inside #if blocks the GLSL compiler will skip,
+// so included files carry #ifndef guards of their own against repeats.
+// The defines go right after #version, and #line directives keep compile
+// errors pointing at the right line; their source number indexes files and,
+// as in GLSL 3.30, "#line n" numbers the line after it n + 1.
+static void preprocess(const std::string &path, const std::string &defines, bool looseFirst,
+                       std::vector<std::string> &files, std::vector<std::string> &including, std::string &out)
+{
+    if (std::find(including.begin(), including.end(), path) != including.end())
+        throw std::runtime_error(path + ": recursive #include");
+    int index = (int)(std::find(files.begin(), files.end(), path) - files.begin());
+    if (index == (int)files.size())
+        files.push_back(path);
+    if (index > 0)
+        out += "#line 0 " + std::to_string(index) + "\n";
+    including.push_back(path);
+    std::istringstream source(readSource(path.c_str(), looseFirst));
+    std::string line;
+    for (int number = 1; std::getline(source, line); number++)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#version") == 0)
+        {
+            out += line + "\n" + defines;
+            out += "#line " + std::to_string(number) + " " + std::to_string(index) + "\n";
+        }
+        else if (start != std::string::npos && line.compare(start, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', start), close = line.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos)
+                throw std::runtime_error(path + ":" + std::to_string(number) + ": malformed #include");
+            std::string name = (std::filesystem::path(path).parent_path() / line.substr(open + 1, close - open - 1))
+                                   .lexically_normal()
+                                   .generic_string();
+            preprocess(name, "", looseFirst, files, including, out);
+            out += "#line " + std::to_string(number) + " " + std::to_string(index) + "\n";
+        }
+        else
+            out += line + "\n";
+    }
+    including.pop_back();
+}
 
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        vShaderFile.close();
-        fShaderFile.close();
+Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath,
+               const std::string &permutation)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), geometryPath(geometryPath ? geometryPath : ""),
+      permutation(permutation)
+{
+    ID = Compile(false, sources);
+    buildUniformTable();
+}
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+GLuint Shader::Compile(bool looseFiles, std::vector<std::string> &files) const
+{
+    std::string vertexCode, fragmentCode, geometryCode;
+    const std::string defines = permutationDefines(permutation);
 
-        if (geometryPath)
+    files.clear();
+    try
+    {
+        // Every stage starts its own #line source numbering
+        std::vector<std::string> stageFiles, including;
+        preprocess(vertexPath, defines, looseFiles, stageFiles, including, vertexCode);
+        files.insert(files.end(), stageFiles.begin(), stageFiles.end());
+        stageFiles.clear();
+        preprocess(fragmentPath, defines, looseFiles, stageFiles, including, fragmentCode);
+        files.insert(files.end(), stageFiles.begin(), stageFiles.end());
+        if (!geometryPath.empty())
         {
-            std::ifstream gShaderFile(geometryPath);
-            if (!gShaderFile.is_open())
-                throw std::runtime_error("Failed to open geometry shader file.");
-
-            std::stringstream gShaderStream;
-            gShaderStream << gShaderFile.rdbuf();
-            gShaderFile.close();
-            geometryCode = gShaderStream.str();
+            stageFiles.clear();
+            preprocess(geometryPath, defines, looseFiles, stageFiles, including, geometryCode);
+            files.insert(files.end(), stageFiles.begin(), stageFiles.end());
         }
     }
     catch (std::exception &e)
     {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        return 0;
     }
 
+    // A cached binary of the same sources on the same driver skips compiling
+    GLuint program = glCreateProgram();
+    const uint64_t cacheKey = ProgramCacheKey({vertexCode, fragmentCode, geometryCode});
+    if (LoadProgramBinary(program, cacheKey))
+        return program;
+
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
 
@@ -57,7 +145,7 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
     checkCompileErrors(fragment, "FRAGMENT");
 
     GLuint geometry = 0;
-    if (geometryPath)
+    if (!geometryPath.empty())
     {
         const char *gShaderCode = geometryCode.c_str();
         geometry = glCreateShader(GL_GEOMETRY_SHADER);
@@ -66,90 +154,135 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
         checkCompileErrors(geometry, "GEOMETRY");
     }
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    if (geometryPath)
-        glAttachShader(ID, geometry);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (geometry)
+        glAttachShader(program, geometry);
+    PrepareProgramBinary(program);
+    glLinkProgram(program);
+    checkCompileErrors(program, "PROGRAM");
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
-    if (geometryPath)
+    if (geometry)
         glDeleteShader(geometry);
-}
 
-Shader::~Shader()
-{
-    glDeleteProgram(ID);
-}
-void Shader::Use() const
-{
-    glUseProgram(ID);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    SaveProgramBinary(program, cacheKey);
+    return program;
 }
 
-void Shader::setBool(const std::string &name, bool value) const
+void Shader::Swap(GLuint program, const std::vector<std::string> &files)
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glDeleteProgram(ID);
+    ID = program;
+    sources = files;
+    buildUniformTable();
 }
 
-void Shader::setInt(const std::string &name, int value) const
+Shader::~Shader()
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glDeleteProgram(ID);
 }
-
-void Shader::setFloat(const std::string &name, float value) const
+void Shader::Use() const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUseProgram(ID);
 }
 
-void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
+namespace
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-}
-
-void Shader::setVec2(const std::string &name, float x, float y) const
+// FNV-1a
+uint32_t HashName(const char *name)
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    uint32_t h = 2166136261u;
+    for (; *name; ++name)
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
 }
+} // namespace
 
-void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
+void Shader::buildUniformTable()
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-}
+    uniforms.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    if (count <= 0)
+        return;
 
-void Shader::setVec3(const std::string &name, float x, float y, float z) const
-{
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
-}
+    // Keys first, since an array adds two of them
+    std::vector<std::pair<std::string, GLint>> keys;
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
 
-void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
-{
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-}
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0)
+            continue; // uniforms inside a block have no location
+        keys.emplace_back(name, location);
+        // Arrays are reported as "name[0]", make them reachable by their plain name too
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            keys.emplace_back(name.substr(0, name.size() - 3), location);
+    }
+    if (keys.empty())
+        return;
 
-void Shader::setVec4(const std::string &name, float x, float y, float z, float w) const
-{
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    // Power of two with at most 50% load, so probes stay short and a miss
+    // always reaches an empty slot
+    size_t capacity = 8;
+    while (capacity < keys.size() * 2)
+        capacity *= 2;
+    uniforms.assign(capacity, UniformSlot{0, -1, std::string()});
+    for (const auto &key : keys)
+    {
+        uint32_t hash = HashName(key.first.c_str());
+        size_t slot = hash & (capacity - 1);
+        while (!uniforms[slot].Name.empty())
+            slot = (slot + 1) & (capacity - 1);
+        uniforms[slot] = UniformSlot{hash, key.second, key.first};
+    }
 }
 
-void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
+UniformHandle Shader::Uniform(const char *name) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-}
+    UniformHandle handle;
+    if (uniforms.empty())
+        return handle;
 
-void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
-{
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    const size_t mask = uniforms.size() - 1;
+    uint32_t hash = HashName(name);
+    size_t slot = hash & mask;
+    for (size_t probes = 0; probes < uniforms.size() && !uniforms[slot].Name.empty(); probes++)
+    {
+        if (uniforms[slot].Hash == hash && uniforms[slot].Name == name)
+        {
+            handle.Location = uniforms[slot].Location;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return handle;
 }
 
-void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
+void Shader::BindBlock(const char *name, GLuint binding) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    GLuint index = glGetUniformBlockIndex(ID, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
 }
 
-void Shader::checkCompileErrors(GLuint shader, std::string type)
+void Shader::checkCompileErrors(GLuint shader, const std::string &type)
 {
     GLint success;
     GLchar infoLog[1024];
@@ -0,0 +1,192 @@
+#include "shader_reloader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderReloader::ShaderReloader(GLFWwindow *window)
+    : context(NULL), notify(-1), stopping(false)
+{
+#ifdef __linux__
+    notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    if (notify < 0)
+    {
+        std::cout << "Shader hot reload is not available on this platform" << std::endl;
+        return;
+    }
+
+    // Same context hints as the window, which are still set
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "Shader compiler", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context)
+    {
+        std::cout << "Failed to create the shader compiler context, hot reload is off" << std::endl;
+#ifdef __linux__
+        close(notify);
+#endif
+        notify = -1;
+        return;
+    }
+    worker = std::thread(&ShaderReloader::run, this);
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    Stop();
+}
+
+void ShaderReloader::Stop()
+{
+    if (!context)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    for (const Build &build : built)
+        glDeleteProgram(build.Program);
+    built.clear();
+    queue.clear();
+    glfwDestroyWindow(context);
+    context = NULL;
+#ifdef __linux__
+    close(notify);
+#endif
+    notify = -1;
+}
+
+void ShaderReloader::Watch(Shader &shader)
+{
+    if (!context)
+        return;
+    shaders.push_back(&shader);
+    for (const std::string &file : shader.Sources())
+        watchDirectory(std::filesystem::path(file).parent_path().generic_string());
+}
+
+void ShaderReloader::watchDirectory(const std::string &directory)
+{
+#ifdef __linux__
+    for (const auto &watched : directories)
+    {
+        if (watched.second == directory)
+            return;
+    }
+    // Editors often save by writing a new file and renaming it over the old one
+    int descriptor = inotify_add_watch(notify, directory.empty() ? "." : directory.c_str(),
+                                       IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0)
+        std::cout << "Failed to watch " << directory << " for shader changes" << std::endl;
+    else
+        directories[descriptor] = directory;
+#endif
+}
+
+bool ShaderReloader::Update()
+{
+    if (!context)
+        return false;
+
+#ifdef __linux__
+    // Every shader with a changed file is queued once, however many events it got
+    std::vector<Shader *> changed;
+    alignas(inotify_event) char events[4096];
+    ssize_t length;
+    while ((length = read(notify, events, sizeof(events))) > 0)
+    {
+        for (char *at = events; at < events + length;)
+        {
+            const inotify_event *event = (const inotify_event *)at;
+            at += sizeof(inotify_event) + event->len;
+            if (event->len == 0 || !directories.count(event->wd))
+                continue;
+            const std::string path =
+                (std::filesystem::path(directories[event->wd]) / event->name).lexically_normal().generic_string();
+            for (Shader *shader : shaders)
+            {
+                const std::vector<std::string> &files = shader->Sources();
+                if (std::find(files.begin(), files.end(), path) != files.end() &&
+                    std::find(changed.begin(), changed.end(), shader) == changed.end())
+                    changed.push_back(shader);
+            }
+        }
+    }
+    if (!changed.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Shader *shader : changed)
+        {
+            if (std::find(queue.begin(), queue.end(), shader) == queue.end())
+                queue.push_back(shader);
+        }
+        wake.notify_all();
+    }
+#endif
+
+    std::vector<Build> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(built);
+    }
+    for (const Build &build : finished)
+    {
+        build.Target->Swap(build.Program, build.Files);
+        // Includes may have been added, their directories need watching too
+        for (const std::string &file : build.Files)
+            watchDirectory(std::filesystem::path(file).parent_path().generic_string());
+        std::cout << "Reloaded " << build.Files[0] << std::endl;
+    }
+    return !finished.empty();
+}
+
+void ShaderReloader::run()
+{
+    glfwMakeContextCurrent(context);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (stopping)
+            break;
+        Shader *shader = queue.front();
+        queue.erase(queue.begin());
+        lock.unlock();
+
+        Build build;
+        build.Target = shader;
+        build.Program = shader->Compile(true, build.Files);
+        // The program must be complete before the other context uses it
+        glFinish();
+
+        lock.lock();
+        if (build.Program)
+        {
+            // A newer build of the same shader supersedes one not swapped in yet
+            for (size_t i = 0; i < built.size(); i++)
+            {
+                if (built[i].Target == shader)
+                {
+                    glDeleteProgram(built[i].Program);
+                    built.erase(built.begin() + i);
+                    break;
+                }
+            }
+            built.push_back(build);
+        }
+        else if (!build.Files.empty())
+            // Not shader->Sources(), which the main thread may be swapping
+            std::cout << "Keeping the running program of " << build.Files[0] << std::endl;
+    }
+    lock.unlock();
+    glfwMakeContextCurrent(NULL);
+}
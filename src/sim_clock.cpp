@@ -0,0 +1,40 @@
+#include "sim_clock.h"
+
+SimClock::SimClock(double stepSize, double speed, int maxSteps)
+    : StepSize(stepSize), MaxSteps(maxSteps), Speed(speed),
+      time(0.0), accumulator(0.0), lastReal(0.0), started(false)
+{
+}
+
+int SimClock::Advance(double realTime)
+{
+    if (!started)
+    {
+        lastReal = realTime;
+        started = true;
+    }
+
+    double elapsed = realTime - lastReal;
+    lastReal = realTime;
+    if (elapsed < 0.0)
+        elapsed = 0.0;
+
+    accumulator += elapsed * Speed;
+    int steps = (int)(accumulator / StepSize);
+    if (steps > MaxSteps)
+    {
+        steps = MaxSteps;
+        accumulator = StepSize * MaxSteps;
+    }
+    accumulator -= steps * StepSize;
+    time += steps * StepSize;
+    return steps;
+}
+
+void SimClock::Reset(double simTime)
+{
+    time = simTime;
+    accumulator = 0.0;
+    // The next Advance starts measuring real time afresh
+    started = false;
+}
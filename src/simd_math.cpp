@@ -0,0 +1,47 @@
+#include "simd_math.h"
+
+#if defined(_MSC_VER) && SIMD_X86
+#include <intrin.h>
+#endif
+
+SimdLevel DetectSimdLevel()
+{
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SIMD_SSE2;
+    return SIMD_SCALAR;
+#elif SIMD_X86
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        // the OS must also save the upper halves of the YMM registers
+        if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+            return SIMD_AVX2;
+    }
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+const char *SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_AVX2:
+        return "AVX2";
+    case SIMD_SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,18 @@
+#include "solar_system.h"
+
+const BodyDesc SOLAR_SYSTEM[] = {
+    // name, semi-major axis, orbit rate, eccentricity, inclination, ascending node, argument of periapsis,
+    // axial tilt, spin rate, mass, radius, parent
+    {"Sun", 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, glm::radians(23.5f) * 0.25f, 1.0f, 100.0f, nullptr},
+    {"Mercury", 100.0f * 2.0f * 1.3f, 1.0f, 0.2056f, 7.005f, 48.331f, 29.124f, 0.0f, glm::radians(-90.0f) * 0.05f, 1.66e-7f, 10.0f, nullptr},
+    {"Venus", 100.0f * 3.0f * 1.3f, 0.75f, 0.0068f, 3.395f, 76.680f, 54.884f, -132.5f, glm::radians(-132.5f) * 0.012f, 2.45e-6f, 12.0f, nullptr},
+    {"Earth", 100.0f * 4.0f * 1.3f, 0.55f, 0.0167f, 0.0f, 0.0f, 102.937f, -33.25f, glm::radians(-33.25f) * 2.0f, 3.0e-6f, 11.8f, nullptr},
+    {"Moon", 100.0f * 0.5f * 1.3f, 67.55f, 0.0549f, 5.145f, 125.08f, 318.15f, -32.4f, glm::radians(-32.4f) * 3.1f, 3.69e-8f, 5.5f, "Earth"},
+    {"Mars", 100.0f * 5.0f * 1.3f, 0.35f, 0.0934f, 1.850f, 49.558f, 286.502f, -32.4f, glm::radians(-32.4f) * 2.1f, 3.23e-7f, 8.0f, nullptr},
+    {"Jupiter", 100.0f * 6.0f * 1.3f, 0.2f, 0.0489f, 1.303f, 100.464f, 273.867f, -23.5f, glm::radians(-23.5f) * 4.5f, 9.55e-4f, 40.0f, nullptr},
+    {"Saturn", 100.0f * 7.0f * 1.3f, 0.15f, 0.0565f, 2.485f, 113.665f, 339.392f, -34.7f, glm::radians(-34.7f) * 4.48f, 2.86e-4f, 37.0f, nullptr},
+    {"Uranus", 100.0f * 8.0f * 1.3f, 0.1f, 0.0463f, 0.773f, 74.006f, 96.998f, -99.0f, glm::radians(-99.0f) * 4.5f, 4.37e-5f, 30.0f, nullptr},
+    {"Neptune", 100.0f * 9.0f * 1.3f, 0.08f, 0.0097f, 1.770f, 131.784f, 273.187f, -30.2f, glm::radians(-30.2f) * 4.0f, 5.15e-5f, 30.0f, nullptr},
+};
+
+const int SOLAR_SYSTEM_COUNT = sizeof(SOLAR_SYSTEM) / sizeof(SOLAR_SYSTEM[0]);
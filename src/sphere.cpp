@@ -1,13 +1,13 @@
 #include "sphere.h"
 
-#include <cmath>
-#include <iostream>
+#include <vector>
 
 Sphere::Sphere(float r, int sectors, int stacks)
-    : radius(r), sectorCount(sectors), stackCount(stacks) {
-    generateVertices();
-    generateIndices();
-    setupBuffers();
+    : Sphere(GenerateUVSphere(r, sectors, stacks)) {
+}
+
+Sphere::Sphere(const SphereMesh &mesh) {
+    setupBuffers(mesh);
 }
 
 Sphere::~Sphere() {
@@ -16,59 +16,7 @@ Sphere::~Sphere() {
     glDeleteBuffers(1, &EBO);
 }
 
-void Sphere::generateVertices() {
-    float x, y, z, xy;
-    float s, t;
-
-    float sectorStep = 2.0f * M_PI / sectorCount;
-    float stackStep = M_PI / stackCount;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stackCount; ++i) {
-        stackAngle = M_PI / 2 - i * stackStep;
-        xy = radius * cosf(stackAngle);
-        z = radius * sinf(stackAngle);
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;
-
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-            s = (float)j / sectorCount;
-            t = (float)i / stackCount;
-
-            sphere_vertices.push_back(x);
-            sphere_vertices.push_back(y);
-            sphere_vertices.push_back(z);
-            sphere_vertices.push_back(s);
-            sphere_vertices.push_back(t);
-        }
-    }
-}
-
-void Sphere::generateIndices() {
-    int k1, k2;
-    for (int i = 0; i < stackCount; ++i) {
-        k1 = i * (sectorCount + 1);
-        k2 = k1 + sectorCount + 1;
-
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-            if (i != 0) {
-                sphere_indices.push_back(k1);
-                sphere_indices.push_back(k2);
-                sphere_indices.push_back(k1 + 1);
-            }
-
-            if (i != (stackCount - 1)) {
-                sphere_indices.push_back(k1 + 1);
-                sphere_indices.push_back(k2);
-                sphere_indices.push_back(k2 + 1);
-            }
-        }
-    }
-}
-
-void Sphere::setupBuffers() {
+void Sphere::setupBuffers(const SphereMesh &mesh) {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -76,12 +24,22 @@ void Sphere::setupBuffers() {
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sphere_vertices.size() * sizeof(float),
-                 sphere_vertices.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, mesh.Vertices.size() * sizeof(float),
+                 mesh.Vertices.data(), GL_STATIC_DRAW);
 
+    // Half the index bandwidth whenever the vertices can be addressed in 16 bits
+    indexCount = static_cast<GLsizei>(mesh.Indices.size());
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere_indices.size() * sizeof(unsigned int),
-                 sphere_indices.data(), GL_DYNAMIC_DRAW);
+    if (mesh.VertexCount() <= 65536) {
+        std::vector<unsigned short> indices(mesh.Indices.begin(), mesh.Indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short),
+                     indices.data(), GL_STATIC_DRAW);
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.Indices.size() * sizeof(unsigned int),
+                     mesh.Indices.data(), GL_STATIC_DRAW);
+    }
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
     glEnableVertexAttribArray(0);
@@ -96,7 +54,33 @@ void Sphere::setupBuffers() {
 
 void Sphere::Draw() {
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphere_indices.size()),
-                   GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+    glBindVertexArray(0);
+}
+
+void Sphere::SetInstanceBuffers(GLuint models, GLuint layers, int first) {
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, models);
+    for (int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat),
+                              (GLvoid*)((first * 16 + column * 4) * sizeof(GLfloat)));
+        glEnableVertexAttribArray(2 + column);
+        glVertexAttribDivisor(2 + column, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, layers);
+    glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                          (GLvoid*)(first * 3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void Sphere::DrawInstanced(GLsizei instances) {
+    glBindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, instances);
     glBindVertexArray(0);
 }
@@ -0,0 +1,29 @@
+#include "sphere_lod.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Coarsest level with at least this many edges around
+static int levelFor(float edges)
+{
+    int level = 0;
+    while (level < SPHERE_LOD_LEVELS - 1 && SPHERE_LOD_EDGES[level] < edges)
+        level++;
+    return level;
+}
+
+SphereLod::SphereLod()
+{
+    for (int edges : SPHERE_LOD_EDGES)
+        levels.push_back(std::unique_ptr<Sphere>(new Sphere(GenerateCubeSphere(1.0f, edges / 4))));
+}
+
+int SphereLod::Select(float screenRadius, int current) const
+{
+    // Edges needed to keep the outline's segments short enough
+    float edges = 2.0f * (float)M_PI * screenRadius / SPHERE_LOD_EDGE_PIXELS;
+    int level = levelFor(edges);
+    if (level >= current)
+        return level;
+    return std::min(current, levelFor(edges * SPHERE_LOD_HYSTERESIS));
+}
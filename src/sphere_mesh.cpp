@@ -0,0 +1,377 @@
+#include "sphere_mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+// Texture coordinates for points on the unit sphere, scaled to radius.
+// Triangles crossing the s = 0 seam get copies of the vertices on the far
+// side with s past 1, and vertices on a pole take the middle s of the rest
+// of each triangle, so no triangle interpolates across the whole map.
+static SphereMesh textured(const std::vector<glm::vec3> &points, const std::vector<unsigned int> &triangles,
+                           float radius)
+{
+    const float pi = (float)M_PI;
+    std::vector<float> s(points.size()), t(points.size());
+    std::vector<bool> pole(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const glm::vec3 &p = points[i];
+        pole[i] = p.x * p.x + p.y * p.y < 1e-10f;
+        s[i] = pole[i] ? 0.0f : atan2f(p.y, p.x) / (2.0f * pi);
+        if (s[i] < 0.0f)
+            s[i] += 1.0f;
+        t[i] = acosf(std::max(-1.0f, std::min(1.0f, p.z))) / pi;
+    }
+
+    SphereMesh mesh;
+    std::map<std::pair<unsigned int, float>, unsigned int> copies; // vertex at a given s
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        float lo = 2.0f, hi = -1.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangles[i + k];
+            if (!pole[v])
+            {
+                lo = std::min(lo, s[v]);
+                hi = std::max(hi, s[v]);
+            }
+        }
+        const bool wraps = hi - lo > 0.5f;
+
+        float ts[3], sum = 0.0f;
+        int sides = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangles[i + k];
+            ts[k] = s[v] + (wraps && s[v] < 0.5f ? 1.0f : 0.0f);
+            if (!pole[v])
+            {
+                sum += ts[k];
+                sides++;
+            }
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangles[i + k];
+            if (pole[v] && sides > 0)
+                ts[k] = sum / sides;
+
+            auto found = copies.find(std::make_pair(v, ts[k]));
+            if (found == copies.end())
+            {
+                found = copies.emplace(std::make_pair(v, ts[k]), (unsigned int)mesh.VertexCount()).first;
+                const glm::vec3 p = points[v] * radius;
+                mesh.Vertices.insert(mesh.Vertices.end(), {p.x, p.y, p.z, ts[k], t[v]});
+            }
+            mesh.Indices.push_back(found->second);
+        }
+    }
+    OptimizeSphereMesh(mesh);
+    return mesh;
+}
+
+SphereMesh GenerateUVSphere(float radius, int sectors, int stacks)
+{
+    SphereMesh mesh;
+    float x, y, z, xy;
+    float s, t;
+
+    float sectorStep = 2.0f * M_PI / sectors;
+    float stackStep = M_PI / stacks;
+    float sectorAngle, stackAngle;
+
+    for (int i = 0; i <= stacks; ++i)
+    {
+        stackAngle = M_PI / 2 - i * stackStep;
+        xy = radius * cosf(stackAngle);
+        z = radius * sinf(stackAngle);
+
+        for (int j = 0; j <= sectors; ++j)
+        {
+            sectorAngle = j * sectorStep;
+
+            x = xy * cosf(sectorAngle);
+            y = xy * sinf(sectorAngle);
+            s = (float)j / sectors;
+            t = (float)i / stacks;
+            mesh.Vertices.insert(mesh.Vertices.end(), {x, y, z, s, t});
+        }
+    }
+
+    // The first and last stacks are fans around the poles
+    unsigned int k1, k2;
+    for (int i = 0; i < stacks; ++i)
+    {
+        k1 = i * (sectors + 1);
+        k2 = k1 + sectors + 1;
+
+        for (int j = 0; j < sectors; ++j, ++k1, ++k2)
+        {
+            if (i != 0)
+                mesh.Indices.insert(mesh.Indices.end(), {k1, k2, k1 + 1});
+            if (i != (stacks - 1))
+                mesh.Indices.insert(mesh.Indices.end(), {k1 + 1, k2, k2 + 1});
+        }
+    }
+    OptimizeSphereMesh(mesh);
+    return mesh;
+}
+
+SphereMesh GenerateIcosphere(float radius, int subdivisions)
+{
+    // One vertex on each pole and two rings of five, offset by half a step
+    std::vector<glm::vec3> points;
+    points.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+    const float z = 1.0f / sqrtf(5.0f), r = 2.0f / sqrtf(5.0f);
+    for (int ring = 0; ring < 2; ring++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            float angle = (2.0f * i + ring) * (float)M_PI / 5.0f;
+            points.push_back(glm::vec3(r * cosf(angle), r * sinf(angle), ring ? -z : z));
+        }
+    }
+    points.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+
+    std::vector<unsigned int> triangles;
+    for (unsigned int i = 0; i < 5; i++)
+    {
+        unsigned int upper = 1 + i, upperNext = 1 + (i + 1) % 5;
+        unsigned int lower = 6 + i, lowerNext = 6 + (i + 1) % 5;
+        triangles.insert(triangles.end(), {0, upper, upperNext});
+        triangles.insert(triangles.end(), {upper, lower, upperNext});
+        triangles.insert(triangles.end(), {upperNext, lower, lowerNext});
+        triangles.insert(triangles.end(), {11, lowerNext, lower});
+    }
+
+    for (int level = 0; level < subdivisions; level++)
+    {
+        // Edges are split once and shared by the triangles on both sides
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> middles;
+        auto middle = [&](unsigned int a, unsigned int b) {
+            auto found = middles.find(std::make_pair(std::min(a, b), std::max(a, b)));
+            if (found != middles.end())
+                return found->second;
+            points.push_back(glm::normalize(points[a] + points[b]));
+            middles[std::make_pair(std::min(a, b), std::max(a, b))] = (unsigned int)points.size() - 1;
+            return (unsigned int)points.size() - 1;
+        };
+
+        std::vector<unsigned int> split;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+            unsigned int ab = middle(a, b), bc = middle(b, c), ca = middle(c, a);
+            split.insert(split.end(), {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+        }
+        triangles.swap(split);
+    }
+    return textured(points, triangles, radius);
+}
+
+SphereMesh GenerateCubeSphere(float radius, int divisions)
+{
+    // Grid lines at equal angles, mirrored so the faces meet exactly
+    std::vector<float> offsets(divisions + 1);
+    for (int i = 0; i <= divisions / 2; i++)
+    {
+        offsets[i] = -tanf((float)M_PI / 4.0f - i * (float)M_PI / (2.0f * divisions));
+        offsets[divisions - i] = -offsets[i];
+    }
+
+    // Vertices are keyed by their grid position on the cube, so the edges
+    // and corners the faces share are one vertex
+    std::vector<glm::vec3> points;
+    std::map<int, unsigned int> grid;
+    auto vertex = [&](int g[3]) {
+        int key = (g[0] * (divisions + 1) + g[1]) * (divisions + 1) + g[2];
+        auto found = grid.find(key);
+        if (found != grid.end())
+            return found->second;
+        points.push_back(glm::normalize(glm::vec3(offsets[g[0]], offsets[g[1]], offsets[g[2]])));
+        grid[key] = (unsigned int)points.size() - 1;
+        return (unsigned int)points.size() - 1;
+    };
+
+    std::vector<unsigned int> triangles;
+    for (int face = 0; face < 6; face++)
+    {
+        // The face across axis a, stepping along b and c with b x c = a
+        const int a = face / 2, b = (a + 1) % 3, c = (a + 2) % 3;
+        const bool positive = face % 2 == 0;
+        for (int i = 0; i < divisions; i++)
+        {
+            for (int j = 0; j < divisions; j++)
+            {
+                unsigned int corners[4];
+                const int steps[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+                for (int k = 0; k < 4; k++)
+                {
+                    int g[3];
+                    g[a] = positive ? divisions : 0;
+                    g[b] = i + steps[k][0];
+                    g[c] = j + steps[k][1];
+                    corners[k] = vertex(g);
+                }
+                if (positive)
+                    triangles.insert(triangles.end(),
+                                     {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]});
+                else
+                    triangles.insert(triangles.end(),
+                                     {corners[0], corners[2], corners[1], corners[0], corners[3], corners[2]});
+            }
+        }
+    }
+    return textured(points, triangles, radius);
+}
+
+// Forsyth's vertex score: recently used vertices are cheap to reuse, the
+// three of the last triangle a little less so it doesn't strip forever, and
+// vertices with few triangles left are finished off before they fall out
+static float vertexScore(int cachePosition, int remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2.0f / sqrtf((float)remaining);
+}
+
+void OptimizeSphereMesh(SphereMesh &mesh)
+{
+    const int vertexCount = mesh.VertexCount();
+    const int triangleCount = (int)mesh.Indices.size() / 3;
+
+    // Triangles not emitted yet around each vertex, the first remaining[v]
+    // entries from offsets[v]
+    std::vector<int> remaining(vertexCount, 0), offsets(vertexCount + 1, 0);
+    for (unsigned int v : mesh.Indices)
+        remaining[v]++;
+    for (int v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<int> adjacency(mesh.Indices.size()), filled(offsets.begin(), offsets.end() - 1);
+    for (int t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+            adjacency[filled[mesh.Indices[3 * t + k]]++] = t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (int v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> added(triangleCount, false);
+    int best = -1;
+    for (int t = 0; t < triangleCount; t++)
+    {
+        const unsigned int *v = &mesh.Indices[3 * t];
+        triangleScore[t] = score[v[0]] + score[v[1]] + score[v[2]];
+        if (best < 0 || triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    std::vector<unsigned int> order;
+    order.reserve(mesh.Indices.size());
+    std::vector<unsigned int> cache, next;
+    int scan = 0;
+    while ((int)order.size() < (int)mesh.Indices.size())
+    {
+        // Nothing left around the cache, start again from any triangle
+        if (best < 0)
+        {
+            while (added[scan])
+                scan++;
+            best = scan;
+        }
+        added[best] = true;
+
+        next.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = mesh.Indices[3 * best + k];
+            order.push_back(v);
+            int *first = &adjacency[offsets[v]];
+            int *last = first + remaining[v];
+            std::iter_swap(std::find(first, last, best), last - 1);
+            remaining[v]--;
+            if (std::find(next.begin(), next.end(), v) == next.end())
+                next.push_back(v);
+        }
+        const size_t emitted = next.size();
+        for (unsigned int v : cache)
+        {
+            if (std::find(next.begin(), next.begin() + emitted, v) == next.begin() + emitted)
+                next.push_back(v);
+        }
+
+        // Rescore everything that moved in the cache, including what fell
+        // out of it, and the triangles around it
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            cachePosition[next[i]] = i < (size_t)VERTEX_CACHE_SIZE ? (int)i : -1;
+            score[next[i]] = vertexScore(cachePosition[next[i]], remaining[next[i]]);
+        }
+        best = -1;
+        for (unsigned int v : next)
+        {
+            for (int a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+            {
+                int t = adjacency[a];
+                const unsigned int *tv = &mesh.Indices[3 * t];
+                triangleScore[t] = score[tv[0]] + score[tv[1]] + score[tv[2]];
+                if (best < 0 || triangleScore[t] > triangleScore[best])
+                    best = t;
+            }
+        }
+        if (next.size() > (size_t)VERTEX_CACHE_SIZE)
+            next.resize(VERTEX_CACHE_SIZE);
+        cache.swap(next);
+    }
+
+    // Vertices follow the triangles, so fetches stay close together
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<float> vertices;
+    vertices.reserve(mesh.Vertices.size());
+    for (unsigned int &v : order)
+    {
+        if (remap[v] < 0)
+        {
+            remap[v] = (int)vertices.size() / 5;
+            vertices.insert(vertices.end(), mesh.Vertices.begin() + 5 * v, mesh.Vertices.begin() + 5 * v + 5);
+        }
+        v = (unsigned int)remap[v];
+    }
+    mesh.Vertices.swap(vertices);
+    mesh.Indices.swap(order);
+}
+
+float InscribedRadius(const SphereMesh &mesh)
+{
+    float closest = INFINITY;
+    for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; k++)
+        {
+            const float *v = &mesh.Vertices[5 * mesh.Indices[i + k]];
+            p[k] = glm::vec3(v[0], v[1], v[2]);
+        }
+        glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        float length = glm::length(normal);
+        if (length > 0.0f)
+            closest = std::min(closest, fabsf(glm::dot(normal, p[0])) / length);
+    }
+    return closest;
+}
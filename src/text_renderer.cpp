@@ -0,0 +1,247 @@
+#include "text_renderer.h"
+
+#include "shader.h"
+#include "stb_easy_font.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+// stb_easy_font glyphs fit an 8 x 12 unit cell, the baseline sits 7 units down
+const int GLYPH_WIDTH = 8;
+const int GLYPH_HEIGHT = 12;
+const int GLYPH_BASELINE = 7;
+
+// Atlas pixels per font unit, plus an empty border so linear filtering
+// never picks up a neighbouring glyph
+const int OVERSAMPLE = 4;
+const int PADDING = 1;
+const int CELL_WIDTH = GLYPH_WIDTH * OVERSAMPLE + 2 * PADDING;
+const int CELL_HEIGHT = GLYPH_HEIGHT * OVERSAMPLE + 2 * PADDING;
+const int ATLAS_COLUMNS = 16;
+const int ATLAS_ROWS = 6;
+const int ATLAS_WIDTH = CELL_WIDTH * ATLAS_COLUMNS;
+const int ATLAS_HEIGHT = CELL_HEIGHT * ATLAS_ROWS;
+
+// Pixels per font unit at scale 1
+const float UNIT = 5.0f;
+} // namespace
+
+TextRenderer::TextRenderer()
+    : labelsDirty(false), viewportWidth(0.0f), viewportHeight(0.0f)
+{
+    buildAtlas();
+
+    glGenVertexArrays(1, &labelVAO);
+    glGenBuffers(1, &labelVBO);
+    glBindVertexArray(labelVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, labelVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, X));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, U));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+TextRenderer::~TextRenderer()
+{
+    glDeleteTextures(1, &atlas);
+    glDeleteVertexArrays(1, &labelVAO);
+    glDeleteBuffers(1, &labelVBO);
+}
+
+void TextRenderer::buildAtlas()
+{
+    std::vector<unsigned char> pixels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+    std::vector<float> quads(4 * 4 * 256); // x, y, z, color per vertex, 4 vertices per quad
+
+    for (int c = 32; c < 128; c++)
+    {
+        int glyph = c - 32;
+        advance[glyph] = stb_easy_font_charinfo[glyph].advance & 15;
+        if (c == 127)
+            continue;
+
+        char text[2] = {(char)c, 0};
+        int count = stb_easy_font_print(0.0f, 0.0f, text, nullptr, quads.data(), (int)(quads.size() * sizeof(float)));
+
+        // Every segment is an axis-aligned rectangle on the unit grid
+        int cellX = (glyph % ATLAS_COLUMNS) * CELL_WIDTH + PADDING;
+        int cellY = (glyph / ATLAS_COLUMNS) * CELL_HEIGHT + PADDING;
+        for (int q = 0; q < count; q++)
+        {
+            const float *v = &quads[q * 16];
+            int x0 = (int)v[0] * OVERSAMPLE, y0 = (int)v[1] * OVERSAMPLE;
+            int x1 = (int)v[8] * OVERSAMPLE, y1 = (int)v[9] * OVERSAMPLE;
+            for (int y = y0; y < y1 && y < GLYPH_HEIGHT * OVERSAMPLE; y++)
+            {
+                for (int x = x0; x < x1 && x < GLYPH_WIDTH * OVERSAMPLE; x++)
+                    pixels[(cellY + y) * ATLAS_WIDTH + cellX + x] = 255;
+            }
+        }
+    }
+
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextRenderer::layout(std::vector<Vertex> &out, const std::string &text, float x, float y, float scale,
+                          const glm::vec3 &color) const
+{
+    const float unit = UNIT * scale;
+    const unsigned char rgba[4] = {(unsigned char)(color.x * 255.0f), (unsigned char)(color.y * 255.0f),
+                                   (unsigned char)(color.z * 255.0f), 255};
+    const float startX = x;
+
+    for (char ch : text)
+    {
+        if (ch == '\n')
+        {
+            x = startX;
+            y -= GLYPH_HEIGHT * unit;
+            continue;
+        }
+        int glyph = (unsigned char)ch - 32;
+        if (glyph < 0 || glyph >= 96)
+            continue;
+
+        if (ch != ' ')
+        {
+            float left = x, right = x + GLYPH_WIDTH * unit;
+            float top = y + GLYPH_BASELINE * unit, bottom = top - GLYPH_HEIGHT * unit;
+
+            // Texture rows run top-down, like the font
+            float u0 = (float)((glyph % ATLAS_COLUMNS) * CELL_WIDTH + PADDING) / ATLAS_WIDTH;
+            float v0 = (float)((glyph / ATLAS_COLUMNS) * CELL_HEIGHT + PADDING) / ATLAS_HEIGHT;
+            float u1 = u0 + (float)(GLYPH_WIDTH * OVERSAMPLE) / ATLAS_WIDTH;
+            float v1 = v0 + (float)(GLYPH_HEIGHT * OVERSAMPLE) / ATLAS_HEIGHT;
+
+            Vertex quad[6] = {
+                {left, top, u0, v0, {}},
+                {left, bottom, u0, v1, {}},
+                {right, bottom, u1, v1, {}},
+                {left, top, u0, v0, {}},
+                {right, bottom, u1, v1, {}},
+                {right, top, u1, v0, {}}};
+            for (Vertex &v : quad)
+            {
+                memcpy(v.Color, rgba, sizeof(rgba));
+                out.push_back(v);
+            }
+        }
+        x += advance[glyph] * unit;
+    }
+}
+
+float TextRenderer::Width(const std::string &text, float scale) const
+{
+    float width = 0.0f, line = 0.0f;
+    for (char ch : text)
+    {
+        int glyph = (unsigned char)ch - 32;
+        if (ch == '\n')
+            line = 0.0f;
+        else if (glyph >= 0 && glyph < 96)
+            line += advance[glyph] * UNIT * scale;
+        width = line > width ? line : width;
+    }
+    return width;
+}
+
+int TextRenderer::CreateLabel(const std::string &text, TextAnchor anchor, float x, float y, float scale,
+                              const glm::vec3 &color)
+{
+    labels.push_back(Label{text, anchor, x, y, scale, color, true, 0, 0});
+    labelsDirty = true;
+    return (int)labels.size() - 1;
+}
+
+void TextRenderer::SetLabelText(int label, const std::string &text)
+{
+    if (labels[label].Text == text)
+        return;
+    labels[label].Text = text;
+    labelsDirty = true;
+}
+
+void TextRenderer::SetLabelVisible(int label, bool visible)
+{
+    labels[label].Visible = visible;
+}
+
+void TextRenderer::SetViewport(float width, float height)
+{
+    if (width == viewportWidth && height == viewportHeight)
+        return;
+    viewportWidth = width;
+    viewportHeight = height;
+    labelsDirty = true;
+}
+
+void TextRenderer::layoutLabels()
+{
+    // Labels change rarely, so all of them are laid out again together
+    std::vector<Vertex> retained;
+    for (Label &label : labels)
+    {
+        bool right = label.Anchor == TEXT_TOP_RIGHT || label.Anchor == TEXT_BOTTOM_RIGHT;
+        bool top = label.Anchor == TEXT_TOP_LEFT || label.Anchor == TEXT_TOP_RIGHT;
+        float x = right ? viewportWidth - label.X : label.X;
+        float y = top ? viewportHeight - label.Y : label.Y;
+
+        label.First = (GLint)retained.size();
+        layout(retained, label.Text, x, y, label.Scale, label.Color);
+        label.Count = (GLsizei)retained.size() - label.First;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, labelVBO);
+    glBufferData(GL_ARRAY_BUFFER, retained.size() * sizeof(Vertex), retained.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    labelsDirty = false;
+}
+
+void TextRenderer::Flush(const Shader &shader)
+{
+    if (labelsDirty)
+        layoutLabels();
+
+    drawFirst.clear();
+    drawCount.clear();
+    for (const Label &label : labels)
+    {
+        if (label.Visible && label.Count > 0)
+        {
+            drawFirst.push_back(label.First);
+            drawCount.push_back(label.Count);
+        }
+    }
+    if (drawFirst.empty())
+        return;
+
+    // The HUD is drawn over everything
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    shader.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glBindVertexArray(labelVAO);
+    glMultiDrawArrays(GL_TRIANGLES, drawFirst.data(), drawCount.data(), (GLsizei)drawFirst.size());
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+}
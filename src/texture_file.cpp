@@ -0,0 +1,46 @@
+#include "texture_file.h"
+
+#include <cstring>
+#include <iostream>
+
+std::string BakedTexturePath(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + TEXTURE_FILE_EXTENSION;
+    return path.substr(0, dot) + TEXTURE_FILE_EXTENSION;
+}
+
+bool ValidateTextureFile(const unsigned char *data, size_t size, const std::string &path)
+{
+    if (size < sizeof(TextureFileHeader) || memcmp(data, TEXTURE_FILE_MAGIC, sizeof(TEXTURE_FILE_MAGIC)) != 0)
+    {
+        std::cout << "Not a baked texture: " << path << std::endl;
+        return false;
+    }
+
+    const TextureFileHeader *header = (const TextureFileHeader *)data;
+    if ((header->Format != TEXTURE_BC1 && header->Format != TEXTURE_BC3) || header->Width == 0 ||
+        header->Height == 0 || header->LevelCount == 0 || header->LevelCount > 32 ||
+        size < sizeof(TextureFileHeader) + header->LevelCount * sizeof(TextureFileLevel))
+    {
+        std::cout << "Baked texture has a malformed header: " << path << std::endl;
+        return false;
+    }
+
+    const TextureFileLevel *levels = (const TextureFileLevel *)(header + 1);
+    uint32_t width = header->Width, height = header->Height;
+    for (uint32_t i = 0; i < header->LevelCount; i++)
+    {
+        if (levels[i].Size != TextureLevelSize(header->Format, width, height) ||
+            (size_t)levels[i].Offset + levels[i].Size > size)
+        {
+            std::cout << "Baked texture level " << i << " is truncated: " << path << std::endl;
+            return false;
+        }
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return true;
+}
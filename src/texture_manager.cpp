@@ -0,0 +1,71 @@
+#include "texture_manager.h"
+
+#include <filesystem>
+#include <system_error>
+
+// Resolves ./ and ../ and symlinks, so different spellings of a path share an entry
+static std::string canonicalPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path : canonical.string();
+}
+
+TextureManager::TextureManager(AssetLoader &loader)
+    : loader(loader)
+{
+}
+
+TextureRef TextureManager::Texture2D(const std::string &path, const TextureParams &params)
+{
+    return acquire(GL_TEXTURE_2D, {path}, params);
+}
+
+TextureRef TextureManager::TextureArray(const std::vector<std::string> &paths, const TextureParams &params)
+{
+    return acquire(GL_TEXTURE_2D_ARRAY, paths, params);
+}
+
+TextureRef TextureManager::Cubemap(const std::vector<std::string> &faces, const TextureParams &params)
+{
+    return acquire(GL_TEXTURE_CUBE_MAP, faces, params);
+}
+
+TextureRef TextureManager::acquire(GLenum target, const std::vector<std::string> &paths, const TextureParams &params)
+{
+    // Target, sampler settings and every image path, separated by newlines
+    std::string key = std::to_string(target) + ' ' + std::to_string(params.Wrap) + ' ' +
+                      std::to_string(params.MinFilter) + ' ' + std::to_string(params.MagFilter) + ' ' +
+                      std::to_string(params.Components);
+    for (const std::string &path : paths)
+        key += '\n' + canonicalPath(path);
+
+    auto found = cache.find(key);
+    if (found != cache.end())
+    {
+        if (TextureRef shared = found->second.lock())
+            return shared;
+    }
+
+    Texture *texture = new Texture();
+    texture->Target = target;
+    if (target == GL_TEXTURE_2D_ARRAY)
+        texture->ID = loader.LoadTextureArray(paths, params);
+    else if (target == GL_TEXTURE_CUBE_MAP)
+        texture->ID = loader.LoadCubemap(paths, params);
+    else
+        texture->ID = loader.LoadTexture(paths[0], params);
+
+    TextureRef shared(texture, [this, key](Texture *released) { release(key, released); });
+    cache[key] = shared;
+    return shared;
+}
+
+void TextureManager::release(const std::string &key, Texture *texture)
+{
+    // A texture still waiting for its images must not be uploaded after deletion
+    loader.Cancel(texture->ID);
+    glDeleteTextures(1, &texture->ID);
+    cache.erase(key);
+    delete texture;
+}
@@ -0,0 +1,349 @@
+#include "texture_residency.h"
+
+#include "asset_loader.h"
+#include "asset_pack.h"
+#include "image_io.h"
+#include "mip_chain.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+// Grey BC1 block: both end points RGB565 (16, 32, 16), every index 0
+static const unsigned char GREY_BLOCK[8] = {0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0};
+
+static size_t levelBytes(int width, int height, int level, bool compressed)
+{
+    const int w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+    return compressed ? TextureLevelSize(TEXTURE_BC1, w, h) : (size_t)w * h * BYTES_PER_TEXEL;
+}
+
+static size_t layerBytes(int width, int height, bool compressed)
+{
+    size_t bytes = 0;
+    for (int level = 0; level < MipLevelCount(width, height); level++)
+        bytes += levelBytes(width, height, level, compressed);
+    return bytes;
+}
+
+static GLuint createArray(int width, int height, int levels, int layers, bool compressed)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    for (int level = 0; level < levels; level++)
+    {
+        const int w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+        if (compressed)
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, w, h, layers, 0,
+                                   (GLsizei)(TextureLevelSize(TEXTURE_BC1, w, h) * layers), NULL);
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, w, h, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return texture;
+}
+
+// Level of the baked BC1 file of path that is width x height and has levels
+// levels below it, -1 if there is no such file
+static int bakedLevel(const std::string &path, int width, int height, int levels)
+{
+    BakedImage baked;
+    if (!AssetExists(BakedTexturePath(path)) || !baked.Open(path))
+        return -1;
+    const TextureFileHeader *header = baked.Header();
+    if (header->Format != TEXTURE_BC1)
+        return -1;
+    for (int level = 0; level + levels <= (int)header->LevelCount; level++)
+    {
+        if (std::max((int)header->Width >> level, 1) == width && std::max((int)header->Height >> level, 1) == height)
+            return level;
+    }
+    return -1;
+}
+
+TextureResidency::TextureResidency(ThreadPool &pool, const std::vector<std::string> &paths, int width, int height,
+                                   size_t budgetBytes)
+    : pool(pool), width(width), height(height), detailArray(0), frame(0)
+{
+    entries.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        entries[i].Path = paths[i];
+
+    baseWidth = std::max(width / RESIDENCY_BASE_DIVISOR, 1);
+    baseHeight = std::max(height / RESIDENCY_BASE_DIVISOR, 1);
+    levels = MipLevelCount(width, height);
+    baseLevels = MipLevelCount(baseWidth, baseHeight);
+    baseShift = 0;
+    while (std::max(width >> baseShift, 1) > baseWidth)
+        baseShift++;
+
+    // Baked BC1 files skip the decode and take an eighth of the memory. They
+    // are used when the driver has S3TC and every texture has one with a
+    // level at the detail size; the base layers are baseShift levels below.
+    compressed = CompressedTexturesSupported() && (baseWidth << baseShift) == width &&
+                 (std::max(height >> baseShift, 1)) == baseHeight;
+    for (Entry &entry : entries)
+    {
+        entry.BakedLevel = compressed ? bakedLevel(entry.Path, width, height, levels) : -1;
+        compressed = compressed && entry.BakedLevel >= 0;
+    }
+
+    // The base array always fits, with one extra layer for the placeholder;
+    // whatever the budget leaves over becomes detail layers
+    const int count = (int)entries.size();
+    size_t baseBytes = (count + 1) * layerBytes(baseWidth, baseHeight, compressed);
+    size_t detailBytes = layerBytes(width, height, compressed);
+    int detailSlots = budgetBytes > baseBytes ? (int)((budgetBytes - baseBytes) / detailBytes) : 0;
+    slots.assign(std::min(detailSlots, count), -1);
+    memoryUsage = baseBytes + slots.size() * detailBytes;
+
+    baseArray = createArray(baseWidth, baseHeight, baseLevels, count + 1, compressed);
+    if (!slots.empty())
+        detailArray = createArray(width, height, levels, (int)slots.size(), compressed);
+
+    std::vector<unsigned char> grey((size_t)baseWidth * baseHeight * 3, 128);
+    if (compressed)
+    {
+        grey.resize(TextureLevelSize(TEXTURE_BC1, baseWidth, baseHeight));
+        for (size_t i = 0; i < grey.size(); i++)
+            grey[i] = GREY_BLOCK[i % 8];
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, baseArray);
+    for (int level = 0; level < baseLevels; level++)
+    {
+        const int w = std::max(baseWidth >> level, 1), h = std::max(baseHeight >> level, 1);
+        if (compressed)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, count, w, h, 1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                      (GLsizei)TextureLevelSize(TEXTURE_BC1, w, h), grey.data());
+        else
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, count, w, h, 1, GL_RGB, GL_UNSIGNED_BYTE, grey.data());
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glGenBuffers(1, &pixelBuffer);
+
+    std::cout << "Planet textures: " << count << " base layers of " << baseWidth << "x" << baseHeight << ", "
+              << slots.size() << " detail layers of " << width << "x" << height << ", "
+              << (compressed ? "BC1, " : "RGB8, ") << memoryUsage / (1024 * 1024) << " MB" << std::endl;
+}
+
+TextureResidency::~TextureResidency()
+{
+    // Pool tasks fill jobs and lock this object's mutex
+    tasks.Wait();
+
+    glDeleteBuffers(1, &pixelBuffer);
+    glDeleteTextures(1, &baseArray);
+    if (detailArray)
+        glDeleteTextures(1, &detailArray);
+}
+
+void TextureResidency::Request(int texture, float screenRadius)
+{
+    Entry &entry = entries[texture];
+    if (entry.LastRequested != frame)
+        entry.ScreenRadius = 0.0f;
+    entry.LastRequested = frame;
+    entry.ScreenRadius = std::max(entry.ScreenRadius, screenRadius);
+}
+
+float TextureResidency::BaseLayer(int texture) const
+{
+    return entries[texture].BaseLoaded ? (float)texture : (float)entries.size();
+}
+
+float TextureResidency::DetailLayer(int texture) const
+{
+    const Entry &entry = entries[texture];
+    return entry.DetailLoaded ? (float)entry.Slot : -1.0f;
+}
+
+void TextureResidency::Update()
+{
+    // A base layer is wanted on first sight, a detail layer once the body
+    // shows more pixels across its equator than the base layer has texels
+    std::vector<int> wanted;
+    for (int i = 0; i < (int)entries.size(); i++)
+    {
+        Entry &entry = entries[i];
+        if (entry.LastRequested != frame || entry.Failed)
+            continue;
+        if (!entry.BaseLoaded && !entry.BaseLoading)
+            queue(i, -1);
+        if (4.0f * entry.ScreenRadius > baseWidth)
+        {
+            entry.LastWanted = frame;
+            if (entry.Slot < 0)
+                wanted.push_back(i);
+        }
+    }
+
+    // Largest on screen first, each takes a free layer or the least recently
+    // wanted one that is neither loading nor wanted this frame
+    std::sort(wanted.begin(), wanted.end(),
+              [this](int a, int b) { return entries[a].ScreenRadius > entries[b].ScreenRadius; });
+    for (int texture : wanted)
+    {
+        int victim = -1;
+        for (int slot = 0; slot < (int)slots.size(); slot++)
+        {
+            if (slots[slot] < 0)
+            {
+                victim = slot;
+                break;
+            }
+            const Entry &owner = entries[slots[slot]];
+            if (owner.DetailLoaded && owner.LastWanted < frame &&
+                (victim < 0 || owner.LastWanted < entries[slots[victim]].LastWanted))
+                victim = slot;
+        }
+        if (victim < 0)
+            break;
+
+        if (slots[victim] >= 0)
+        {
+            entries[slots[victim]].Slot = -1;
+            entries[slots[victim]].DetailLoaded = false;
+        }
+        slots[victim] = texture;
+        entries[texture].Slot = victim;
+        queue(texture, victim);
+    }
+
+    size_t uploaded = 0;
+    for (size_t i = 0; i < jobs.size() && uploaded < ASSET_UPLOAD_BUDGET;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!jobs[i]->Done)
+            {
+                i++;
+                continue;
+            }
+        }
+        const Job &job = *jobs[i];
+        Entry &entry = entries[job.Texture];
+        if (!job.Failed)
+        {
+            upload(job);
+            uploaded += job.Pixels.size();
+        }
+        entry.Failed = entry.Failed || job.Failed;
+        if (job.Slot < 0)
+        {
+            entry.BaseLoading = false;
+            entry.BaseLoaded = !job.Failed;
+        }
+        else if (job.Failed)
+        {
+            slots[job.Slot] = -1;
+            entry.Slot = -1;
+        }
+        else
+            entry.DetailLoaded = true;
+        jobs.erase(jobs.begin() + i);
+    }
+
+    frame++;
+}
+
+void TextureResidency::queue(int texture, int slot)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->Texture = texture;
+    job->Slot = slot;
+    job->Width = slot < 0 ? baseWidth : width;
+    job->Height = slot < 0 ? baseHeight : height;
+    if (slot < 0)
+        entries[texture].BaseLoading = true;
+    jobs.push_back(job);
+
+    const std::string path = entries[texture].Path;
+    if (compressed)
+    {
+        // The levels are copied out of the baked file as they are
+        const int first = entries[texture].BakedLevel + (slot < 0 ? baseShift : 0);
+        const int count = slot < 0 ? baseLevels : levels;
+        tasks.Submit(pool, [this, job, path, first, count]() {
+            BakedImage baked;
+            if (baked.Open(path))
+            {
+                for (int level = first; level < first + count; level++)
+                {
+                    const TextureFileLevel &source = baked.Level(level);
+                    job->Pixels.insert(job->Pixels.end(), baked.Data() + source.Offset,
+                                       baked.Data() + source.Offset + source.Size);
+                }
+            }
+            else
+                job->Failed = true;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            job->Done = true;
+        });
+        return;
+    }
+
+    tasks.Submit(pool, [this, job, path]() {
+        // Halve larger sources down to the layer size, then build the mip chain
+        std::vector<unsigned char> level;
+        int w, h;
+        if (!DecodeImageRGB(path, level, w, h))
+            job->Failed = true;
+        else if (ReduceImage(level, w, h, job->Width, job->Height))
+            AppendMipChain(job->Pixels, std::move(level), w, h, MipLevelCount(w, h));
+        else
+        {
+            std::cout << "Texture " << path << " does not reduce to " << job->Width << "x" << job->Height
+                      << std::endl;
+            job->Failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        job->Done = true;
+    });
+}
+
+// Stage the mip chain or its blocks in the pixel buffer and copy every level into the layer
+void TextureResidency::upload(const Job &job)
+{
+    if (StagePixels(pixelBuffer, job.Pixels.data(), job.Pixels.size()))
+    {
+        const bool base = job.Slot < 0;
+        const int layer = base ? job.Texture : job.Slot;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, base ? baseArray : detailArray);
+        size_t offset = 0;
+        for (int level = 0; level < (base ? baseLevels : levels); level++)
+        {
+            int w = std::max(job.Width >> level, 1), h = std::max(job.Height >> level, 1);
+            if (compressed)
+            {
+                GLsizei size = (GLsizei)TextureLevelSize(TEXTURE_BC1, w, h);
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1,
+                                          GL_COMPRESSED_RGB_S3TC_DXT1_EXT, size, (void *)offset);
+                offset += size;
+            }
+            else
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                                (void *)offset);
+                offset += (size_t)w * h * 3;
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    else
+        std::cout << "Failed to map the pixel buffer for " << entries[job.Texture].Path << std::endl;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
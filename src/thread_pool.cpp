@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(int threads)
+    : stopping(false)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : workers)
+        t.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(int count, int grain, const std::function<void(int, int)> &fn)
+{
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    const int chunks = (count + grain - 1) / grain;
+    if (chunks == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    // Helpers may only get to run after the loop is finished, so the shared
+    // state outlives this call and late helpers find no chunks left
+    struct State
+    {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    // fn is only touched while chunks remain, which the caller waits for
+    auto run = [state, count, grain, chunks, &fn]() {
+        int c;
+        while ((c = state->next.fetch_add(1)) < chunks)
+        {
+            int begin = c * grain;
+            int end = begin + grain < count ? begin + grain : count;
+            fn(begin, end);
+            if (state->done.fetch_add(1) + 1 == chunks)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    int helpers = Size() < chunks - 1 ? Size() : chunks - 1;
+    for (int i = 0; i < helpers; i++)
+        Submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state, chunks]() { return state->done.load() == chunks; });
+}
+
+void PendingTasks::Submit(ThreadPool &pool, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running++;
+    }
+    pool.Submit([this, task]() {
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+        finished.notify_all();
+    });
+}
+
+void PendingTasks::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return running == 0; });
+}
@@ -0,0 +1,386 @@
+// Bakes source images into S3TC compressed textures with precomputed mip
+// chains, written next to each image as <name>.ctex. The app prefers a baked
+// file over its source image when the driver supports S3TC. Images with an
+// alpha channel become BC3, all others BC1. Up to date outputs are skipped.
+//
+// usage: bake_assets [image or directory]...   (default: resources)
+
+#include "texture_file.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Rgba
+{
+    float R, G, B, A;
+};
+
+// RGB565 round trip, expanded the way the hardware does
+static uint16_t Pack565(const float c[3])
+{
+    int r = (int)std::lround(std::fmin(std::fmax(c[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+    int g = (int)std::lround(std::fmin(std::fmax(c[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+    int b = (int)std::lround(std::fmin(std::fmax(c[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void Unpack565(uint16_t v, float c[3])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (float)((r << 3) | (r >> 2));
+    c[1] = (float)((g << 2) | (g >> 4));
+    c[2] = (float)((b << 3) | (b >> 2));
+}
+
+static float Distance2(const Rgba &p, const float c[3])
+{
+    float dr = p.R - c[0], dg = p.G - c[1], db = p.B - c[2];
+    return dr * dr + dg * dg + db * db;
+}
+
+// Indices of the four-colour palette for the given endpoints, returns the total error
+static float AssignColors(const Rgba block[16], uint16_t e0, uint16_t e1, uint32_t &indices)
+{
+    float palette[4][3];
+    Unpack565(e0, palette[0]);
+    Unpack565(e1, palette[1]);
+    for (int k = 0; k < 3; k++)
+    {
+        palette[2][k] = (2.0f * palette[0][k] + palette[1][k]) / 3.0f;
+        palette[3][k] = (palette[0][k] + 2.0f * palette[1][k]) / 3.0f;
+    }
+
+    float error = 0.0f;
+    indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        float bestDistance = Distance2(block[i], palette[0]);
+        for (int j = 1; j < 4; j++)
+        {
+            float d = Distance2(block[i], palette[j]);
+            if (d < bestDistance)
+            {
+                bestDistance = d;
+                best = j;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+        error += bestDistance;
+    }
+    return error;
+}
+
+// Colour block: endpoints along the principal axis of the pixels, then one
+// least-squares refit of the endpoints to the chosen indices
+static void EncodeColorBlock(const Rgba block[16], unsigned char *out)
+{
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+    {
+        mean[0] += block[i].R / 16.0f;
+        mean[1] += block[i].G / 16.0f;
+        mean[2] += block[i].B / 16.0f;
+    }
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+    {
+        float r = block[i].R - mean[0], g = block[i].G - mean[1], b = block[i].B - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Power iteration from the luminance direction
+    float axis[3] = {0.299f, 0.587f, 0.114f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::sqrt(x * x + y * y + z * z);
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float lo = 1e30f, hi = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = (block[i].R - mean[0]) * axis[0] + (block[i].G - mean[1]) * axis[1] + (block[i].B - mean[2]) * axis[2];
+        lo = std::fmin(lo, t);
+        hi = std::fmax(hi, t);
+    }
+    float c0[3], c1[3];
+    for (int k = 0; k < 3; k++)
+    {
+        c0[k] = mean[k] + hi * axis[k];
+        c1[k] = mean[k] + lo * axis[k];
+    }
+    uint16_t e0 = Pack565(c0), e1 = Pack565(c1);
+    uint32_t indices;
+    float error = AssignColors(block, e0, e1, indices);
+
+    // Solve for the endpoints that best reproduce the pixels with these indices
+    static const float WEIGHT[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        float a = WEIGHT[(indices >> (2 * i)) & 3], b = 1.0f - a;
+        const float p[3] = {block[i].R, block[i].G, block[i].B};
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int k = 0; k < 3; k++)
+        {
+            ax[k] += a * p[k];
+            bx[k] += b * p[k];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) > 1e-6f)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            c0[k] = (ax[k] * bb - bx[k] * ab) / det;
+            c1[k] = (bx[k] * aa - ax[k] * ab) / det;
+        }
+        uint16_t r0 = Pack565(c0), r1 = Pack565(c1);
+        uint32_t refined;
+        if (AssignColors(block, r0, r1, refined) < error)
+        {
+            e0 = r0;
+            e1 = r1;
+            indices = refined;
+        }
+    }
+
+    // e0 > e1 selects the four-colour mode in BC1
+    if (e0 < e1)
+    {
+        std::swap(e0, e1);
+        indices ^= 0x55555555; // 0 <-> 1, 2 <-> 3
+    }
+    else if (e0 == e1)
+        indices = 0;
+
+    out[0] = (unsigned char)(e0 & 0xff);
+    out[1] = (unsigned char)(e0 >> 8);
+    out[2] = (unsigned char)(e1 & 0xff);
+    out[3] = (unsigned char)(e1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// BC3 alpha block: eight interpolated values between the block's extremes
+static void EncodeAlphaBlock(const Rgba block[16], unsigned char *out)
+{
+    float lo = 255.0f, hi = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        lo = std::fmin(lo, block[i].A);
+        hi = std::fmax(hi, block[i].A);
+    }
+    int a0 = (int)std::lround(hi), a1 = (int)std::lround(lo);
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+
+    float palette[8] = {(float)a0, (float)a1};
+    for (int k = 1; k < 7; k++)
+        palette[k + 1] = ((7 - k) * a0 + k * a1) / 7.0f;
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        if (a0 > a1)
+        {
+            for (int j = 1; j < 8; j++)
+            {
+                if (std::fabs(block[i].A - palette[j]) < std::fabs(block[i].A - palette[best]))
+                    best = j;
+            }
+        }
+        bits |= (uint64_t)best << (3 * i);
+    }
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Half-size level by a 2x2 box filter, odd edges repeat the last pixel
+static std::vector<Rgba> Downsample(const std::vector<Rgba> &src, int width, int height)
+{
+    int w = width > 1 ? width / 2 : 1, h = height > 1 ? height / 2 : 1;
+    std::vector<Rgba> dst((size_t)w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+            const Rgba &a = src[(size_t)y0 * width + x0], &b = src[(size_t)y0 * width + x1];
+            const Rgba &c = src[(size_t)y1 * width + x0], &d = src[(size_t)y1 * width + x1];
+            dst[(size_t)y * w + x] = {(a.R + b.R + c.R + d.R) * 0.25f, (a.G + b.G + c.G + d.G) * 0.25f,
+                                      (a.B + b.B + c.B + d.B) * 0.25f, (a.A + b.A + c.A + d.A) * 0.25f};
+        }
+    }
+    return dst;
+}
+
+static void EncodeLevel(const std::vector<Rgba> &pixels, int width, int height, uint32_t format,
+                        std::vector<unsigned char> &out)
+{
+    const uint32_t blockBytes = TextureBlockBytes(format);
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            // Partial blocks at the edges repeat the last row and column
+            Rgba block[16];
+            for (int i = 0; i < 16; i++)
+            {
+                int x = std::min(bx + (i & 3), width - 1), y = std::min(by + (i >> 2), height - 1);
+                block[i] = pixels[(size_t)y * width + x];
+            }
+            size_t offset = out.size();
+            out.resize(offset + blockBytes);
+            if (format == TEXTURE_BC3)
+            {
+                EncodeAlphaBlock(block, &out[offset]);
+                offset += 8;
+            }
+            EncodeColorBlock(block, &out[offset]);
+        }
+    }
+}
+
+static bool Bake(const fs::path &input, const fs::path &output)
+{
+    int width, height, channels;
+    unsigned char *data = stbi_load(input.string().c_str(), &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "Failed to load " << input.string() << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    bool alpha = false;
+    std::vector<Rgba> pixels((size_t)width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        const unsigned char *p = data + 4 * i;
+        pixels[i] = {(float)p[0], (float)p[1], (float)p[2], (float)p[3]};
+        alpha = alpha || p[3] < 255;
+    }
+    stbi_image_free(data);
+
+    TextureFileHeader header;
+    memcpy(header.Magic, TEXTURE_FILE_MAGIC, sizeof(header.Magic));
+    header.Format = alpha ? TEXTURE_BC3 : TEXTURE_BC1;
+    header.Width = width;
+    header.Height = height;
+    header.LevelCount = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        header.LevelCount++;
+
+    std::vector<TextureFileLevel> levels(header.LevelCount);
+    std::vector<unsigned char> blocks;
+    const uint32_t dataStart = (uint32_t)(sizeof(header) + levels.size() * sizeof(TextureFileLevel));
+    int w = width, h = height;
+    for (uint32_t level = 0; level < header.LevelCount; level++)
+    {
+        if (level > 0)
+        {
+            pixels = Downsample(pixels, w, h);
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        levels[level].Offset = dataStart + (uint32_t)blocks.size();
+        EncodeLevel(pixels, w, h, header.Format, blocks);
+        levels[level].Size = dataStart + (uint32_t)blocks.size() - levels[level].Offset;
+    }
+
+    std::ofstream file(output, std::ios::binary);
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)levels.data(), levels.size() * sizeof(TextureFileLevel));
+    file.write((const char *)blocks.data(), blocks.size());
+    if (!file)
+    {
+        std::cout << "Failed to write " << output.string() << std::endl;
+        return false;
+    }
+
+    size_t raw = (size_t)width * height * (alpha ? 4 : 3);
+    std::cout << output.string() << ": " << width << "x" << height << " " << (alpha ? "BC3" : "BC1") << ", "
+              << header.LevelCount << " levels, " << (raw / 1024) << " KB -> "
+              << ((blocks.size() + dataStart) / 1024) << " KB" << std::endl;
+    return true;
+}
+
+static bool IsImage(const fs::path &path)
+{
+    std::string ext = path.extension().string();
+    for (char &c : ext)
+        c = (char)tolower(c);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".tga";
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<fs::path> inputs;
+    std::vector<std::string> roots;
+    for (int i = 1; i < argc; i++)
+        roots.push_back(argv[i]);
+    if (roots.empty())
+        roots.push_back("resources");
+
+    for (const std::string &root : roots)
+    {
+        std::error_code error;
+        if (fs::is_directory(root, error))
+        {
+            for (const fs::directory_entry &entry : fs::recursive_directory_iterator(root, error))
+            {
+                if (entry.is_regular_file() && IsImage(entry.path()))
+                    inputs.push_back(entry.path());
+            }
+        }
+        else if (fs::is_regular_file(root, error))
+            inputs.push_back(root);
+        else
+            std::cout << "No such image or directory: " << root << std::endl;
+    }
+
+    int failed = 0, skipped = 0;
+    for (const fs::path &input : inputs)
+    {
+        fs::path output = BakedTexturePath(input.string());
+        std::error_code error;
+        if (fs::exists(output, error) && fs::last_write_time(output, error) >= fs::last_write_time(input, error))
+        {
+            skipped++;
+            continue;
+        }
+        if (!Bake(input, output))
+            failed++;
+    }
+    std::cout << inputs.size() - skipped - failed << " baked, " << skipped << " up to date, " << failed << " failed"
+              << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+// Headless micro-benchmark for the Kepler propagator.
+// Reports bodies propagated per second on one core for every instruction
+// set the CPU supports, then on all cores with the best one.
+//
+// usage: bench_kepler [bodies] [iterations]
+
+#include "kepler.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    if (count <= 0 || iterations <= 0)
+    {
+        std::cout << "usage: bench_kepler [bodies] [iterations]" << std::endl;
+        return 1;
+    }
+
+    // A main-belt-like population with a fixed seed so runs are comparable
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    KeplerOrbits orbits;
+    for (int i = 0; i < count; i++)
+    {
+        float a = 2.1f + 1.2f * unit(rng);
+        orbits.Add(a, 0.3f * unit(rng), 0.5f * unit(rng), 6.2831853f * unit(rng), 6.2831853f * unit(rng),
+                   6.2831853f * unit(rng), 1.0f / (a * sqrtf(a)));
+    }
+    std::vector<float> x(count), y(count), z(count);
+
+    SimdLevel best = DetectSimdLevel();
+    std::cout << count << " bodies, " << iterations << " iterations, " << KEPLER_ITERATIONS
+              << " Halley steps per solve" << std::endl;
+
+    for (int level = SIMD_SCALAR; level <= best; level++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++)
+            PropagateKepler(orbits, 1000.0 + it, 0, count, x.data(), y.data(), z.data(), (SimdLevel)level);
+        double t = Seconds(start);
+        std::cout << "1 thread  " << SimdLevelName((SimdLevel)level) << ": "
+                  << (double)count * iterations / t / 1e6 << " M bodies/s" << std::endl;
+    }
+
+    // Split into chunks that are a multiple of the widest vector
+    int threads = (int)std::thread::hardware_concurrency();
+    if (threads < 1)
+        threads = 1;
+    int chunk = ((count + threads - 1) / threads + 7) & ~7;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; w++)
+    {
+        int first = w * chunk;
+        int n = first + chunk > count ? count - first : chunk;
+        if (n <= 0)
+            break;
+        workers.emplace_back([&, first, n]() {
+            for (int it = 0; it < iterations; it++)
+                PropagateKepler(orbits, 1000.0 + it, first, n, x.data(), y.data(), z.data(), best);
+        });
+    }
+    for (std::thread &t : workers)
+        t.join();
+    double t = Seconds(start);
+    std::cout << threads << " thread(s) " << SimdLevelName(best) << ": "
+              << (double)count * iterations / t / 1e6 << " M bodies/s" << std::endl;
+
+    return 0;
+}
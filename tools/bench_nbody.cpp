@@ -0,0 +1,106 @@
+// Headless benchmark for the Barnes-Hut gravity engine.
+// Builds a sun, eight planets and a disc of light particles, then reports
+// the step rate on one thread and on all hardware threads, plus the force
+// error of the chosen opening angle against direct summation.
+//
+// usage: bench_nbody [particles] [steps] [theta] [leapfrog|yoshida]
+
+#include "nbody.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void BuildScene(NBodySystem &sim, int particles)
+{
+    const double sunMass = 1.0;
+    sim.Add(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, sunMass);
+
+    const double planetRadius[8] = {0.39, 0.72, 1.0, 1.52, 5.2, 9.54, 19.2, 30.1};
+    const double planetMass[8] = {1.66e-7, 2.45e-6, 3.0e-6, 3.23e-7, 9.55e-4, 2.86e-4, 4.37e-5, 5.15e-5};
+    for (int i = 0; i < 8; i++)
+    {
+        double v = std::sqrt(sim.G * sunMass / planetRadius[i]);
+        sim.Add(planetRadius[i], 0.0, 0.0, 0.0, 0.0, v, planetMass[i]);
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < particles; i++)
+    {
+        double r = 2.0 + 1.5 * unit(rng);
+        double phi = 6.283185307179586 * unit(rng);
+        double h = 0.05 * (unit(rng) - 0.5);
+        double v = std::sqrt(sim.G * sunMass / r);
+        sim.Add(r * std::cos(phi), h, r * std::sin(phi), -v * std::sin(phi), 0.0, v * std::cos(phi), 1e-10);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int particles = argc > 1 ? atoi(argv[1]) : 50000;
+    int steps = argc > 2 ? atoi(argv[2]) : 10;
+    double theta = argc > 3 ? atof(argv[3]) : 0.5;
+    std::string integrator = argc > 4 ? argv[4] : "leapfrog";
+    if (particles < 0 || steps <= 0 || theta < 0.0 || (integrator != "leapfrog" && integrator != "yoshida"))
+    {
+        std::cout << "usage: bench_nbody [particles] [steps] [theta] [leapfrog|yoshida]" << std::endl;
+        return 1;
+    }
+
+    NBodySystem sim;
+    sim.Theta = theta;
+    sim.Softening = 1e-4;
+    sim.Integrator = integrator == "yoshida" ? NBODY_YOSHIDA4 : NBODY_LEAPFROG;
+    BuildScene(sim, particles);
+    const double dt = 1e-3;
+
+    // Force error against direct summation on a sample of bodies
+    sim.ComputeForces(nullptr);
+    std::vector<double> ax(sim.AX), ay(sim.AY), az(sim.AZ);
+    sim.Theta = 0.0;
+    sim.ComputeForces(nullptr);
+    double worst = 0.0, mean = 0.0;
+    int samples = sim.Count() < 200 ? sim.Count() : 200;
+    for (int s = 0; s < samples; s++)
+    {
+        int i = (int)((long long)s * sim.Count() / samples);
+        double dx = ax[i] - sim.AX[i], dy = ay[i] - sim.AY[i], dz = az[i] - sim.AZ[i];
+        double ref = std::sqrt(sim.AX[i] * sim.AX[i] + sim.AY[i] * sim.AY[i] + sim.AZ[i] * sim.AZ[i]);
+        double err = std::sqrt(dx * dx + dy * dy + dz * dz) / ref;
+        worst = err > worst ? err : worst;
+        mean += err / samples;
+    }
+    sim.Theta = theta;
+
+    std::cout << sim.Count() << " bodies, theta " << theta << ", " << integrator << ", " << sim.NodeCount() << " nodes" << std::endl;
+    std::cout << "force error vs direct sum: mean " << mean << ", max " << worst << std::endl;
+
+    double e0 = sim.Energy();
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+        sim.Step(dt, nullptr);
+    double single = Seconds(start);
+    std::cout << "1 thread: " << steps / single << " steps/s, "
+              << (double)sim.Count() * steps / single / 1e6 << " M bodies/s" << std::endl;
+
+    ThreadPool pool;
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+        sim.Step(dt, &pool);
+    double multi = Seconds(start);
+    std::cout << pool.Size() << " thread(s): " << steps / multi << " steps/s, "
+              << (double)sim.Count() * steps / multi / 1e6 << " M bodies/s" << std::endl;
+
+    std::cout << "relative energy drift: " << (sim.Energy() - e0) / std::fabs(e0) << std::endl;
+    return 0;
+}
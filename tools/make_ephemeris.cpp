@@ -0,0 +1,145 @@
+// Builds a Chebyshev ephemeris for the scene's bodies from the project's own
+// orbit propagator, then reads it back and reports the fitting error.
+// Times are in orbit time; the app runs at 0.1 orbit time per second by default.
+//
+// usage: make_ephemeris [output] [start] [end] [order]
+
+#include "body_registry.h"
+#include "ephemeris.h"
+#include "solar_system.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Length of one record in orbit time
+const double RECORD_LENGTH = 8.0;
+
+// Position of body i relative to its parent, as the registry computes it
+static void Sample(BodyRegistry &bodies, int i, double time, double p[3])
+{
+    bodies.Update(time, 0.0);
+    glm::vec3 pos = bodies.Position[i];
+    if (bodies.Parent[i] >= 0)
+        pos -= bodies.Position[bodies.Parent[i]];
+    p[0] = pos.x;
+    p[1] = pos.y;
+    p[2] = pos.z;
+}
+
+int main(int argc, char **argv)
+{
+    std::string output = argc > 1 ? argv[1] : "resources/ephemeris.bin";
+    double start = argc > 2 ? atof(argv[2]) : 0.0;
+    double end = argc > 3 ? atof(argv[3]) : 3600.0;
+    int order = argc > 4 ? atoi(argv[4]) : 16;
+    if (end <= start || order < 2)
+    {
+        std::cout << "usage: make_ephemeris [output] [start] [end] [order]" << std::endl;
+        return 1;
+    }
+
+    BodyRegistry bodies;
+    for (int i = 0; i < SOLAR_SYSTEM_COUNT; i++)
+        bodies.Add(SOLAR_SYSTEM[i]);
+    const int n = bodies.Count();
+
+    EphemerisHeader header;
+    memcpy(header.Magic, EPHEMERIS_MAGIC, sizeof(header.Magic));
+    header.BodyCount = n;
+    header.RecordCount = (uint32_t)ceil((end - start) / RECORD_LENGTH);
+    header.RecordSize = 0;
+    header.Reserved = 0;
+    header.StartTime = start;
+    header.RecordLength = RECORD_LENGTH;
+
+    // One sub-interval per revolution, two for strongly eccentric orbits whose
+    // harmonics would need a higher order; bodies that do not move need a single term.
+    std::vector<EphemerisBody> records(n);
+    for (int i = 0; i < n; i++)
+    {
+        EphemerisBody &b = records[i];
+        memset(&b, 0, sizeof(b));
+        strncpy(b.Name, bodies.Name[i].c_str(), sizeof(b.Name) - 1);
+        double revolutions = RECORD_LENGTH * bodies.OrbitRate[i] / 6.283185307179586;
+        bool moving = bodies.OrbitRadius[i] > 0.0f && bodies.OrbitRate[i] != 0.0f;
+        b.Order = moving ? order : 1;
+        double perRevolution = bodies.Eccentricity[i] > 0.1f ? 2.0 : 1.0;
+        b.SubIntervals = moving ? (uint32_t)ceil(perRevolution * revolutions) : 1;
+        b.Offset = header.RecordSize;
+        header.RecordSize += 3 * b.Order * b.SubIntervals;
+    }
+
+    std::ofstream file(output, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Failed to create " << output << std::endl;
+        return 1;
+    }
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)records.data(), n * sizeof(EphemerisBody));
+
+    std::vector<double> record(header.RecordSize);
+    std::vector<double> samples(3 * order);
+    for (uint32_t r = 0; r < header.RecordCount; r++)
+    {
+        double t0 = start + r * RECORD_LENGTH;
+        for (int i = 0; i < n; i++)
+        {
+            const EphemerisBody &b = records[i];
+            double span = RECORD_LENGTH / b.SubIntervals;
+            for (uint32_t s = 0; s < b.SubIntervals; s++)
+            {
+                double mid = t0 + (s + 0.5) * span;
+                for (uint32_t j = 0; j < b.Order; j++)
+                {
+                    double p[3];
+                    Sample(bodies, i, mid + 0.5 * span * ChebyshevNode(j, b.Order), p);
+                    for (int c = 0; c < 3; c++)
+                        samples[c * b.Order + j] = p[c];
+                }
+                double *coefficients = &record[b.Offset + s * 3 * b.Order];
+                for (int c = 0; c < 3; c++)
+                    FitChebyshev(&samples[c * b.Order], b.Order, coefficients + c * b.Order);
+            }
+        }
+        file.write((const char *)record.data(), record.size() * sizeof(double));
+    }
+    file.close();
+    if (!file)
+    {
+        std::cout << "Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    Ephemeris ephemeris;
+    if (!ephemeris.Load(output))
+        return 1;
+    std::cout << output << ": " << n << " bodies, " << header.RecordCount << " records, orbit time "
+              << ephemeris.StartTime() << " to " << ephemeris.EndTime() << ", "
+              << (sizeof(header) + n * sizeof(EphemerisBody) + header.RecordCount * header.RecordSize * sizeof(double)) / 1024
+              << " KiB" << std::endl;
+
+    // Compare against the propagator at random times
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> when(start, ephemeris.EndTime());
+    for (int i = 0; i < n; i++)
+    {
+        double worst = 0.0;
+        for (int s = 0; s < 2000; s++)
+        {
+            double t = when(rng), p[3], q[3];
+            Sample(bodies, i, t, p);
+            ephemeris.Evaluate(i, t, q[0], q[1], q[2]);
+            double err = sqrt((p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]));
+            worst = err > worst ? err : worst;
+        }
+        std::cout << "  " << bodies.Name[i] << ": order " << records[i].Order << " x " << records[i].SubIntervals
+                  << " per record, max error " << worst << std::endl;
+    }
+    return 0;
+}
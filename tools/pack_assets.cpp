@@ -0,0 +1,124 @@
+// Packs resource directories into one archive for AssetPack. Entries are
+// named by their path relative to the working directory, e.g.
+// resources/planets/2k_sun.jpg, which is how the app refers to them.
+// Baked .ctex files from bake_assets are packed like any other file.
+//
+// usage: pack_assets [output] [directory or file]...   (default: assets.pack resources shaders)
+
+#include "asset_pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static uint64_t AlignUp(uint64_t offset)
+{
+    return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+}
+
+int main(int argc, char **argv)
+{
+    std::string output = argc > 1 ? argv[1] : "assets.pack";
+    std::vector<std::string> roots;
+    for (int i = 2; i < argc; i++)
+        roots.push_back(argv[i]);
+    if (roots.empty())
+        roots = {"resources", "shaders"};
+
+    std::vector<std::string> files;
+    for (const std::string &root : roots)
+    {
+        std::error_code error;
+        if (fs::is_directory(root, error))
+        {
+            for (const fs::directory_entry &entry : fs::recursive_directory_iterator(root, error))
+            {
+                if (entry.is_regular_file())
+                    files.push_back(entry.path().lexically_normal().generic_string());
+            }
+        }
+        else if (fs::is_regular_file(root, error))
+            files.push_back(fs::path(root).lexically_normal().generic_string());
+        else
+        {
+            std::cout << "No such file or directory: " << root << std::endl;
+            return 1;
+        }
+    }
+
+    // Name order is both the lookup order and the layout order, so files of
+    // the same directory end up next to each other
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    AssetPackHeader header;
+    memcpy(header.Magic, ASSET_PACK_MAGIC, sizeof(header.Magic));
+    header.EntryCount = (uint32_t)files.size();
+
+    std::vector<AssetPackEntry> entries(files.size());
+    std::string names;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        entries[i].NameOffset = (uint32_t)names.size();
+        entries[i].NameLength = (uint32_t)files[i].size();
+        names += files[i];
+    }
+    header.NamesSize = (uint32_t)names.size();
+
+    uint64_t offset = AlignUp(sizeof(header) + entries.size() * sizeof(AssetPackEntry) + names.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        entries[i].Offset = offset;
+        entries[i].Size = (uint64_t)fs::file_size(files[i]);
+        offset = AlignUp(offset + entries[i].Size);
+    }
+
+    std::ofstream pack(output, std::ios::binary);
+    pack.write((const char *)&header, sizeof(header));
+    pack.write((const char *)entries.data(), entries.size() * sizeof(AssetPackEntry));
+    pack.write(names.data(), names.size());
+
+    std::vector<char> buffer;
+    for (size_t i = 0; i < files.size() && pack; i++)
+    {
+        // Zero padding up to the entry's page
+        std::vector<char> padding((size_t)(entries[i].Offset - (uint64_t)pack.tellp()), 0);
+        pack.write(padding.data(), padding.size());
+
+        std::ifstream file(files[i], std::ios::binary);
+        buffer.resize((size_t)entries[i].Size);
+        if (!file.read(buffer.data(), buffer.size()))
+        {
+            std::cout << "Failed to read " << files[i] << std::endl;
+            return 1;
+        }
+        pack.write(buffer.data(), buffer.size());
+    }
+    if (!pack)
+    {
+        std::cout << "Failed to write " << output << std::endl;
+        return 1;
+    }
+    pack.close();
+
+    // Read it back through the same path the app uses
+    AssetPack check;
+    if (!check.Open(output))
+        return 1;
+    for (const std::string &file : files)
+    {
+        if (check.Find(file).Size != fs::file_size(file))
+        {
+            std::cout << "Verification failed for " << file << std::endl;
+            return 1;
+        }
+    }
+    std::cout << output << ": " << files.size() << " files, " << (offset / 1024) << " KB" << std::endl;
+    return 0;
+}